@@ -99,7 +99,7 @@ void Graph_ParseAdjListText(Graph* graph, FILE* fin)
 		// 空白区切りの数値テキストをパースする。strtok 関数を用いる。
 		// strtok 関数を呼び出すたびに tp は数値テキストの先頭を指すようになる。
 		// atoi 関数によってそれを数値に変換する。
-		tp = strtok(buff, " ");
+		tp = strtok(buff, " \t\r\n"); // 改行も区切る（空行の "\n" を頂点 0 と読まない）
 		while (tp != NULL) {
 			x = atoi(tp);
 			Edge edge;
@@ -130,7 +130,7 @@ void Graph_ParseAdjListText(Graph* graph, FILE* fin)
 					}
 				}
 			}
-			tp = strtok(NULL, " ");
+			tp = strtok(NULL, " \t\r\n");
 		}
 	}
 	if (graph->number_of_vertices < max_vertex) {
@@ -472,6 +472,10 @@ int64 ZDD_GetNumberOfSolutions(ZDD* zdd)
 {
 	int i, j;
 
+	if (zdd->node_array_list_size <= 2) { // 辺がない（根の子がないが，s != t なので解はない）
+		return 0;
+	}
+
 	ZeroTerminal->sol = 0;
 	OneTerminal->sol = 1;
 
@@ -600,9 +604,11 @@ ZDDNode* CheckTerminal(ZDDNode* n_hat, int i, int x, State* state)
 		}
 	}
 	if (i == state->graph->edge_list_size) { // 最後の辺の処理
+		// s, t に接続する辺がなければ s, t はフロンティアに入らず，上で次数を確かめていない
+		int ok = (n_prime->deg[state->s] == 1 && n_prime->deg[state->t] == 1);
 		ZDDNode_Destruct(n_prime);
 		free(n_prime);
-		return OneTerminal;
+		return (ok ? OneTerminal : ZeroTerminal);
 	}
 	ZDDNode_Destruct(n_prime);
 	free(n_prime);
@@ -19,626 +19,1555 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <iostream>
-#include <sstream>
 #include <string>
-#include <vector>
 #include <algorithm>
-
-// main 関数は本コードの末尾にある。
-// アルゴリズム本体は FrontierAlgorithm クラスの Construct 関数である。
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <iterator>
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <climits>
+#include <random>
+#include <functional>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "frontier.h"
+#include "reduce.h"
+#include "zddmanager.h"
+
+// フロンティア法（s-tパスの場合）のコマンドラインプログラム。
+// アルゴリズム本体はライブラリ（frontier.h, frontier.cpp）にある。
 
 using namespace std;
+using namespace frontier;
 
 //******************************************************************************
-// 補助関数
-
-// 配列 vec に，element が含まれるかどうかを判定。
-// 含まれるなら true を，含まれないなら false を返す。
-static bool Contains(const vector<int>& vec, int element)
+// ベンチマーク
+// 2 x 2 から max_size x max_size までの格子グラフについて，
+// 各アルゴリズムの構築時間を比較する。解の数は左上から右下への s-t パスの数。
+// frontier（deg/comp 版）は等価ノードの探索が線形なので，7 x 7 以上では省略する。
+// packed は使える SIMD 命令セットそれぞれについて計測する。
+// 解の個数の計算時間は num_threads 個のスレッドで計測する。構築した順のままのものと，
+// ZDD::Renumber で並べ替えた後のもの（renumber はその並べ替えの時間）を比べる。
+static void RunBenchmark(int max_size, int num_threads)
 {
-	return std::find(vec.begin(), vec.end(), element) != vec.end();
-}
+	struct BenchEntry {
+		const char* algorithm;
+		SimdLevel simd;
+	};
+	const BenchEntry entries[] = { { "frontier", kSimdScalar }, { "simpath", kSimdScalar },
+		{ "packed", kSimdScalar }, { "packed", kSimdSse2 }, { "packed", kSimdAvx2 } };
+	SimdLevel max_simd = DetectSimdLevel();
+
+	cout << "size\talgorithm\tnodes\tsolutions\ttime(ms)\tcount(ms)\trenumber(ms)"
+		<< "\trenumbered count(ms)" << endl;
+	for (int k = 2; k <= max_size; ++k) {
+		Graph graph;
+		graph.MakeGrid(k, k);
+		State state(&graph, 1, graph.GetNumberOfVertices());
+
+		for (size_t a = 0; a < sizeof(entries) / sizeof(entries[0]); ++a) {
+			string algorithm = entries[a].algorithm;
+			if ((algorithm == "frontier" && k >= 7) || entries[a].simd > max_simd) {
+				continue;
+			}
+			ConstructOptions options;
+			options.simd = entries[a].simd;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			ZDD* zdd = ConstructByName(algorithm, &state, options);
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+			start = std::chrono::steady_clock::now();
+			int64_t solutions = zdd->GetNumberOfSolutions(num_threads);
+			end = std::chrono::steady_clock::now();
+			double count_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+			start = std::chrono::steady_clock::now();
+			zdd->Renumber();
+			end = std::chrono::steady_clock::now();
+			double renumber_ms = std::chrono::duration<double, std::milli>(end - start).count();
+			start = std::chrono::steady_clock::now();
+			int64_t renumbered_solutions = zdd->GetNumberOfSolutions(num_threads);
+			end = std::chrono::steady_clock::now();
+			double renumbered_count_ms = std::chrono::duration<double, std::milli>(end - start).count();
+			if (renumbered_solutions != solutions) {
+				cerr << "renumbered ZDD has " << renumbered_solutions << " solutions" << endl;
+			}
 
-// 配列 vec の中から element を全て削除する。
-static void Remove(vector<int>* vec, int element)
-{
-	vec->erase(std::remove(vec->begin(), vec->end(), element), vec->end());
+			if (algorithm == "packed") {
+				algorithm += string("(") + GetSimdLevelName(entries[a].simd) + ")";
+			}
+			cout << k << "x" << k << "\t" << algorithm
+				<< "\t" << zdd->GetNumberOfNodes() << "\t" << solutions
+				<< "\t" << ms << "\t" << count_ms << "\t" << renumber_ms
+				<< "\t" << renumbered_count_ms << endl;
+			delete zdd;
+		}
+	}
 }
 
 //******************************************************************************
-// Edge 構造体
-// グラフの辺を表す。
-struct Edge {
-public:
-	int src;  // 辺の始点
-	int dest; // 辺の終点
+// 差分検証（-verify）
+// 無作為な小さいグラフ（頂点は 0 から max_vertices 個，16 個に1個は辺のないもの）を作り，
+// 各アルゴリズム・各方式で s-t パス（s = 1, t = 頂点の数）を求めた結果を，すべての s-t パスを
+// 深さ優先探索で列挙したものと比べる。解の個数に加えて，ZDD を作る方式は ZDDManager に
+// 取り込んで既約にしたノード数を，列挙した集合族から作った既約な ZDD のノード数と比べる
+// （既約な ZDD は辺の順序だけで決まる）。ZDD の解の個数は 1 スレッドと num_threads 個の
+// スレッド，ZDD::Renumber の後で数えて比べる。c_program を指定すれば C 版のプログラムに同じ隣接リストを渡して実行し，
+// 既約にする前のノード数を frontier（同じ手順の C++ 版）と比べる。
+// グラフごとの各方式の時間（ミリ秒。ZDD を作る方式は構築と 1 スレッドでの数え上げの和，
+// C 版はプロセスの起動を含む）を横に並べて標準出力に出力し，食い違いはそのグラフの
+// 隣接リストとともに標準エラー出力に出力する。
+
+// 方式ごとの結果
+struct VerifyResult {
+	int64_t nodes;     // 既約にした ZDD のノード数（終端を除く。ZDD を作らない方式は -1）
+	int64_t raw_nodes; // 既約にする前のノード数（終端を含む。ZDD を作らない方式は -1）
+	int64_t solutions; // 解の個数（実行に失敗したら -1）
+	double ms;         // 時間（ミリ秒）
+	ConstructFallback fallback; // メモリ予算で切り替えた方法
+	string note;       // 方式の中での食い違い（空でなければ誤り）
+
+	VerifyResult() : nodes(-1), raw_nodes(-1), solutions(-1), ms(0), fallback(kFallbackNone) { }
+};
 
-	Edge(int src_a, int dest_a)
-	{
-		src = src_a;
-		dest = dest_a;
-	}
+// 方式の名前と，グラフとその隣接リストを受け取って結果を格納する関数
+struct VerifyEngine {
+	string name;
+	std::function<void(Graph*, const string&, VerifyResult*)> run;
 };
 
-//******************************************************************************
-// Graph 構造体
-// （無向）グラフを表す。グラフは辺のリスト(vector)によって表される。
-class Graph {
-private:
-	int number_of_vertices_; // 頂点の数
-	vector<Edge> edge_list_; // 辺リスト
+static double GetElapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-public:
-	int GetNumberOfVertices() // 頂点の数を返す
-	{
-		return number_of_vertices_;
+// v から t への単純パスを深さ優先探索で延ばし，t に着いたら path（辺の番号）を整列して paths に加える
+static void SearchPaths(const vector<vector<std::pair<int, int> > >& adjacency, int v, int t,
+	vector<bool>* visited, vector<int>* path, vector<vector<int> >* paths)
+{
+	if (v == t) {
+		vector<int> sorted = *path;
+		std::sort(sorted.begin(), sorted.end());
+		paths->push_back(sorted);
+		return;
 	}
+	(*visited)[v] = true;
+	for (size_t k = 0; k < adjacency[v].size(); ++k) {
+		int u = adjacency[v][k].first;
+		if (!(*visited)[u]) {
+			path->push_back(adjacency[v][k].second);
+			SearchPaths(adjacency, u, t, visited, path, paths);
+			path->pop_back();
+		}
+	}
+	(*visited)[v] = false;
+}
 
-	const vector<Edge>& GetEdgeList() // 辺リストを返す
-	{
-		return edge_list_;
+// 集合族 family（各集合は辺の番号の昇順の配列。同じ集合を含まない）の既約な ZDD の根を返す。
+// unique は (辺, 0枝の先, 1枝の先) からノードの番号（終端が 0, 1 なので 2 から）への一意表で，
+// 作ったノードの数が unique->size() になる
+static int64_t MakeReducedNode(const vector<vector<int> >& family,
+	std::map<vector<int64_t>, int64_t>* unique)
+{
+	if (family.empty()) {
+		return 0;
+	}
+	int e = INT_MAX; // 集合に現れる最小の辺（ZDD の根のレベル）
+	for (size_t k = 0; k < family.size(); ++k) {
+		if (!family[k].empty()) {
+			e = std::min(e, family[k][0]);
+		}
+	}
+	if (e == INT_MAX) { // 空集合だけ
+		return 1;
 	}
+	vector<vector<int> > lo, hi; // e を含まない集合，e を含む集合から e を除いたもの
+	for (size_t k = 0; k < family.size(); ++k) {
+		if (!family[k].empty() && family[k][0] == e) {
+			hi.push_back(vector<int>(family[k].begin() + 1, family[k].end()));
+		} else {
+			lo.push_back(family[k]);
+		}
+	}
+	vector<int64_t> key(3);
+	key[0] = e;
+	key[1] = MakeReducedNode(lo, unique);
+	key[2] = MakeReducedNode(hi, unique);
+	std::map<vector<int64_t>, int64_t>::iterator it = unique->find(key);
+	if (it != unique->end()) {
+		return it->second;
+	}
+	int64_t id = static_cast<int64_t>(unique->size()) + 2;
+	unique->insert(std::make_pair(key, id));
+	return id;
+}
 
-	// ファイルから隣接リスト形式のグラフを読み込む
-	void ParseAdjListText(istream& ist)
-	{
-		number_of_vertices_ = 0;
-		edge_list_.clear();
-
-		string s;
-		int max_vertex = 0;
-		while (std::getline(ist, s)) {
-			++number_of_vertices_;
-
-			// 以下では，s に格納されている "1 4 6 10 15" などの
-			// 空白区切りの数値テキストをパースする。
-			istringstream iss(s);
-			int x;
-			while (iss >> x) {
-				Edge edge(number_of_vertices_, x);
-				if (number_of_vertices_ > x) { // src < dest になるように格納
-					std::swap(edge.src, edge.dest);
-				}
+// m 本の辺のグラフの zdd（NULL なら失敗）のノード数と解の個数を result に格納して zdd を解放する。
+// 解の個数は 1 スレッドで数え，num_threads 個のスレッドで数えたものや Renumber の後に
+// 数えたものと食い違えば note に記す
+static void MeasureZDD(ZDD* zdd, int m, std::chrono::steady_clock::time_point start,
+	int num_threads, VerifyResult* result)
+{
+	if (zdd == NULL) {
+		result->ms = GetElapsedMs(start);
+		return;
+	}
+	result->solutions = zdd->GetNumberOfSolutions(1);
+	result->ms = GetElapsedMs(start);
+	result->raw_nodes = zdd->GetNumberOfNodes();
+	int64_t parallel = zdd->GetNumberOfSolutions(num_threads);
+	if (parallel != result->solutions) {
+		ostringstream oss;
+		oss << "# of solutions with " << num_threads << " threads = " << parallel;
+		result->note = oss.str();
+	}
+	zdd->Renumber();
+	int64_t renumbered = zdd->GetNumberOfSolutions(num_threads);
+	if (renumbered != result->solutions) {
+		ostringstream oss;
+		oss << "# of solutions after renumbering = " << renumbered;
+		result->note = oss.str();
+	}
+	ZDDManager manager(m);
+	result->nodes = manager.GetNumberOfNodes(manager.Import(zdd));
+	delete zdd;
+}
 
-				if (edge.src != edge.dest) { // src == dest のものは無視
-					if (max_vertex < x) {
-						max_vertex = x;
-					}
+// C 版のプログラムに隣接リストを標準入力から渡して実行し，標準エラー出力の
+// "# of nodes of ZDD = ..., # of solutions = ..." を読む
+static void RunCProgram(const string& program, const string& text, VerifyResult* result)
+{
+	char path[] = "/tmp/frontier-verify-XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		result->note = "cannot create a temporary file";
+		return;
+	}
+	bool written = write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+	close(fd);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	string command = "'" + program + "' < " + path + " 2>&1 > /dev/null";
+	FILE* pipe = (written ? popen(command.c_str(), "r") : NULL);
+	if (pipe != NULL) {
+		char line[256];
+		long long nodes, solutions;
+		while (std::fgets(line, sizeof(line), pipe) != NULL) {
+			if (std::sscanf(line, "# of nodes of ZDD = %lld, # of solutions = %lld",
+					&nodes, &solutions) == 2) {
+				result->raw_nodes = nodes;
+				result->solutions = solutions;
+			}
+		}
+		if (pclose(pipe) != 0) {
+			result->solutions = -1;
+			result->note = "the C program failed";
+		}
+	} else {
+		result->note = "cannot run " + program;
+	}
+	result->ms = GetElapsedMs(start);
+	unlink(path);
+}
 
-					size_t e;
-					for (e = 0; e < edge_list_.size(); ++e) { // 重複除去
-						if (edge_list_[e].src == edge.src && edge_list_[e].dest == edge.dest) {
-							break;
-						}
-					}
-					if (e >= edge_list_.size()) { // 重複が見つからない
-						edge_list_.push_back(edge); // 辺を追加
+static int RunVerify(int number_of_graphs, int max_vertices, uint64_t seed,
+	const string& c_program, int num_threads)
+{
+	vector<VerifyEngine> engines;
+	if (!c_program.empty()) {
+		engines.push_back(VerifyEngine { "c", [c_program](Graph*, const string& text, VerifyResult* r) {
+			RunCProgram(c_program, text, r);
+		} });
+	}
+	const char* algorithms[] = { "frontier", "simpath" };
+	for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); ++a) {
+		string algorithm = algorithms[a];
+		engines.push_back(VerifyEngine { algorithm, [algorithm, num_threads](Graph* graph,
+				const string&, VerifyResult* r) {
+			State state(graph, 1, graph->GetNumberOfVertices());
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			MeasureZDD(ConstructByName(algorithm, &state, ConstructOptions()),
+				static_cast<int>(graph->GetEdgeList().size()), start, num_threads, r);
+		} });
+	}
+	for (int simd = kSimdScalar; simd <= DetectSimdLevel(); ++simd) {
+		SimdLevel level = static_cast<SimdLevel>(simd);
+		engines.push_back(VerifyEngine { string("packed(") + GetSimdLevelName(level) + ")",
+				[level, num_threads](Graph* graph, const string&, VerifyResult* r) {
+			State state(graph, 1, graph->GetNumberOfVertices());
+			ConstructOptions options;
+			options.simd = level;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			MeasureZDD(PackedFrontierAlgorithm::Construct(&state, options),
+				static_cast<int>(graph->GetEdgeList().size()), start, num_threads, r);
+		} });
+	}
+	engines.push_back(VerifyEngine { "processes", [num_threads](Graph* graph, const string&,
+			VerifyResult* r) {
+		State state(graph, 1, graph->GetNumberOfVertices());
+		ConstructOptions options;
+		options.num_processes = 2;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		MeasureZDD(PackedFrontierAlgorithm::Construct(&state, options),
+			static_cast<int>(graph->GetEdgeList().size()), start, num_threads, r);
+	} });
+	// メモリ予算を 1 バイト（すぐに spill に切り替わる），または count-only に切り替わって
+	// spill までは進まない大きさにして構築する。後者は，予算なしで構築したときの見積もりの
+	// 最大値のすぐ下から，spill に進む間は 1.5 倍ずつ増やして探す（時間には含めない）
+	const char* budgets[] = { "count-only", "spill" };
+	for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); ++b) {
+		bool spill = (b == 1);
+		engines.push_back(VerifyEngine { budgets[b], [spill, num_threads](Graph* graph,
+				const string&, VerifyResult* r) {
+			State state(graph, 1, graph->GetNumberOfVertices());
+			ConstructReport report;
+			ConstructOptions options;
+			options.report = &report;
+			options.memory_budget = 1;
+			if (!spill) {
+				ConstructOptions measure;
+				measure.report = &report;
+				delete PackedFrontierAlgorithm::Construct(&state, measure);
+				options.memory_budget = std::max<int64_t>(1, report.peak_memory - 1);
+				for (int trial = 0; trial < 8; ++trial) {
+					delete PackedFrontierAlgorithm::Construct(&state, options);
+					if (report.fallback != kFallbackSpill) {
+						break;
 					}
+					options.memory_budget += options.memory_budget / 2;
 				}
 			}
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			ZDD* zdd = PackedFrontierAlgorithm::Construct(&state, options);
+			if (zdd != NULL) { // 予算に収まった
+				MeasureZDD(zdd, static_cast<int>(graph->GetEdgeList().size()), start, num_threads, r);
+			} else {
+				r->ms = GetElapsedMs(start);
+				r->solutions = report.number_of_solutions;
+			}
+			r->fallback = report.fallback;
+		} });
+	}
+	engines.push_back(VerifyEngine { "reduced", [](Graph* graph, const string&, VerifyResult* r) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		ReducedGraph reduced;
+		ReduceGraph(graph, 1, graph->GetNumberOfVertices(), &reduced);
+		vector<ZDD*> zdds;
+		for (size_t k = 0; k < reduced.cores.size(); ++k) {
+			ReducedCore& core = reduced.cores[k];
+			State state(&core.graph, core.s, core.t);
+			zdds.push_back(PackedFrontierAlgorithm::Construct(&state, ConstructOptions()));
 		}
-		if (number_of_vertices_ < max_vertex) {
-			number_of_vertices_ = max_vertex;
+		ZDDManager manager(static_cast<int>(graph->GetEdgeList().size()));
+		ZDDManager::NodeId f = ExpandReducedGraph(reduced, zdds, &manager);
+		for (size_t k = 0; k < zdds.size(); ++k) {
+			delete zdds[k];
 		}
-	}
+		r->ms = GetElapsedMs(start);
+		r->solutions = manager.Count(f);
+		r->nodes = manager.GetNumberOfNodes(f);
+	} });
+	engines.push_back(VerifyEngine { "query", [](Graph* graph, const string&, VerifyResult* r) {
+		State state(graph, 1, graph->GetNumberOfVertices());
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		r->solutions = PathQuery::CountUpTo(&state, INT64_MAX);
+		r->ms = GetElapsedMs(start);
+	} });
+	engines.push_back(VerifyEngine { "approx", [](Graph* graph, const string&, VerifyResult* r) {
+		State state(graph, 1, graph->GetNumberOfVertices());
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		ApproximateCount count;
+		ApproximateCounter::Count(&state, 1 << 16, 1, 1, &count); // 間引かないので厳密になる
+		r->ms = GetElapsedMs(start);
+		r->solutions = static_cast<int64_t>(std::llround(count.estimate));
+		if (!count.exact) {
+			r->note = "not exact";
+		}
+	} });
 
-	string ToString()
-	{
-		ostringstream oss;
-		for (size_t i = 0; i < edge_list_.size(); ++i)
-		{
-			oss << "(" << edge_list_[i].src << ", " << edge_list_[i].dest
-				<< ")";
-			if (i < edge_list_.size() - 1)
-			{
-				oss << ", ";
+	cout << "graph\tvertices\tedges\tsolutions\tnodes";
+	for (size_t k = 0; k < engines.size(); ++k) {
+		cout << "\t" << engines[k].name << "(ms)";
+	}
+	cout << endl;
+
+	std::mt19937_64 random(seed);
+	vector<double> total_ms(engines.size(), 0.0);
+	// メモリ予算で count-only, spill に切り替えたグラフの数
+	vector<int> count_only(engines.size(), 0), spilled(engines.size(), 0);
+	int number_of_mismatches = 0;
+	for (int g = 1; g <= number_of_graphs; ++g) {
+		// 隣接リスト（i 行目は i より大きい隣接頂点）を作り，CLI と同じく読み込む
+		int n = std::uniform_int_distribution<int>(0, max_vertices)(random);
+		double p = (g % 16 == 0 ? 0.0 : std::uniform_real_distribution<double>(0.2, 0.9)(random));
+		std::bernoulli_distribution coin(p);
+		ostringstream text;
+		for (int v = 1; v <= n; ++v) {
+			for (int u = v + 1; u <= n; ++u) {
+				if (coin(random)) {
+					text << u << " ";
+				}
 			}
+			text << "\n";
+		}
+		Graph graph;
+		istringstream ist(text.str());
+		graph.ParseAdjListText(ist);
+		const vector<Edge>& edge_list = graph.GetEdgeList();
+
+		// すべての s-t パスを列挙して，解の個数と既約な ZDD のノード数を求める
+		vector<vector<std::pair<int, int> > > adjacency(n + 1);
+		for (size_t e = 0; e < edge_list.size(); ++e) {
+			adjacency[edge_list[e].src].push_back(std::make_pair(edge_list[e].dest, static_cast<int>(e)));
+			adjacency[edge_list[e].dest].push_back(std::make_pair(edge_list[e].src, static_cast<int>(e)));
+		}
+		vector<bool> visited(n + 1, false);
+		vector<int> path;
+		vector<vector<int> > paths;
+		if (n >= 2) { // s = 1, t = n。頂点が 1 個以下なら s-t パスはない
+			SearchPaths(adjacency, 1, n, &visited, &path, &paths);
+		}
+		std::map<vector<int64_t>, int64_t> unique;
+		MakeReducedNode(paths, &unique);
+		int64_t expected_solutions = static_cast<int64_t>(paths.size());
+		int64_t expected_nodes = static_cast<int64_t>(unique.size());
+
+		vector<VerifyResult> results(engines.size());
+		bool mismatch = false;
+		for (size_t k = 0; k < engines.size(); ++k) {
+			VerifyResult& r = results[k];
+			engines[k].run(&graph, text.str(), &r);
+			total_ms[k] += r.ms;
+			count_only[k] += (r.fallback == kFallbackCountOnly ? 1 : 0);
+			spilled[k] += (r.fallback == kFallbackSpill ? 1 : 0);
+			if (r.solutions != expected_solutions || (r.nodes >= 0 && r.nodes != expected_nodes)
+				|| !r.note.empty()) {
+				cerr << "graph " << g << ": " << engines[k].name << ": # of nodes = " << r.nodes
+					<< " (expected " << expected_nodes << "), # of solutions = " << r.solutions
+					<< " (expected " << expected_solutions << ")"
+					<< (r.note.empty() ? "" : ", ") << r.note << endl;
+				mismatch = true;
+			}
+		}
+		// C 版と frontier は同じ手順なので，既約にする前のノード数も一致する
+		if (!c_program.empty() && results[0].raw_nodes != results[1].raw_nodes) {
+			cerr << "graph " << g << ": # of nodes of the C program = " << results[0].raw_nodes
+				<< ", frontier = " << results[1].raw_nodes << endl;
+			mismatch = true;
+		}
+		if (mismatch) {
+			cerr << "graph " << g << " (adjacency list):" << endl << text.str();
+			++number_of_mismatches;
 		}
-		return oss.str();
-	}
-};
-
-//******************************************************************************
-// ZDDNode 構造体
-// ZDDノードを表す。
-class ZDDNode {
-public:
-	int* deg;  // deg 配列（フロンティア法アルゴリズムの文献参照）
-	int* comp; // comp 配列（フロンティア法アルゴリズムの文献参照）
-	int64_t sol; // 解の数の計算時に使用する変数
-	ZDDNode* zero_child; // 0枝側の子ノード
-	ZDDNode* one_child;  // 1枝側の子ノード
-
-	static ZDDNode* ZeroTerminal; // 0終端
-	static ZDDNode* OneTerminal;  // 1終端
 
-private:
-	int id_; // ノードID。0終端は0，1終端は1，それ以外のノードは2から始まる整数
+		cout << g << "\t" << n << "\t" << edge_list.size() << "\t" << expected_solutions
+			<< "\t" << expected_nodes;
+		for (size_t k = 0; k < engines.size(); ++k) {
+			cout << "\t" << results[k].ms;
+		}
+		cout << endl;
+	}
+	cout << "total\t\t\t\t";
+	for (size_t k = 0; k < engines.size(); ++k) {
+		cout << "\t" << total_ms[k];
+	}
+	cout << endl;
+	cerr << "# of graphs = " << number_of_graphs << ", # of mismatched graphs = " << number_of_mismatches;
+	for (size_t k = 0; k < engines.size(); ++k) {
+		if (count_only[k] + spilled[k] > 0) {
+			cerr << ", " << engines[k].name << ": count-only on " << count_only[k]
+				<< " graphs, spill on " << spilled[k] << " graphs";
+		}
+	}
+	cerr << endl;
+	return (number_of_mismatches > 0 ? 1 : 0);
+}
 
-	static int total_id_; // 次に与えるノードID
-	static ZDDNode zero_t_; // 0終端実体
-	static ZDDNode one_t_;  // 1終端実体
+static void PrintUsage()
+{
+	cerr << "usage: frontier-stpath-basic [-a frontier|simpath|packed]"
+		<< " [-simd scalar|sse2|avx2] [-threads n]" << endl;
+	cerr << "       [-checkpoint dir [-checkpoint-interval sec] [-resume]]"
+		<< " [-processes n [-shard-dir dir]] [-reduce] [-memory-profile] [-renumber]" << endl;
+	cerr << "       [-order input|bfs|search [-order-time sec] [-order-threads n] [-order-sum]]" << endl;
+	cerr << "       [-memory-budget MB [-spill-dir dir]] [-directed] [-pairs s1:t1,s2:t2,...]" << endl;
+	cerr << "       [-include e1,e2,...] [-exclude e1,e2,...] [-onset e] [-offset e] ..."
+		<< " [-delete e1,e2,...] [-export sapporo|graphillion]" << endl;
+	cerr << "       [-approx B [-approx-replicates R] [-approx-seed S]]" << endl;
+	cerr << "       [-weights file [-maximize]] [-exists | -count-cap K | -paths k]"
+		<< " [-f adj|edge|dimacs] [-i graph_file | < graph_file]" << endl;
+	cerr << "       frontier-stpath-basic -plan input,bfs,search [-plan-beam B] [-plan-walks W]"
+		<< " [-f adj|edge|dimacs] [-i graph_file | < graph_file]" << endl;
+	cerr << "       frontier-stpath-basic -server [-server-socket path] [-server-workers n]"
+		<< " [-a ...] [-directed] [-f adj|edge|dimacs]" << endl;
+	cerr << "       frontier-stpath-basic [-threads n] -bench <max_grid_size>" << endl;
+	cerr << "       frontier-stpath-basic [-threads n] -verify <number_of_graphs> [-verify-vertices n]"
+		<< " [-verify-seed S] [-verify-c c_program]" << endl;
+}
 
-public:
-	// ZDD, ZDDNode を使用するときはこの関数を必ず呼ぶこと。
-	// 終端ノードの初期化を行う。
-	static void Initialize()
-	{
-		ZeroTerminal = &zero_t_;
-		OneTerminal = &one_t_;
-		ZeroTerminal->id_ = 0;
-		OneTerminal->id_ = 1;
-		ZeroTerminal->deg = NULL;
-		OneTerminal->deg = NULL;
-		ZeroTerminal->comp = NULL;
-		OneTerminal->comp = NULL;
+// パス（辺の番号の配列）を "(1, 2), (2, 4)" のように出力する
+static void PrintPath(Graph* graph, const vector<int>& path)
+{
+	const vector<Edge>& edge_list = graph->GetEdgeList();
+	for (size_t k = 0; k < path.size(); ++k) {
+		cout << (k > 0 ? ", " : "") << "(" << edge_list[path[k]].src << ", "
+			<< edge_list[path[k]].dest << ")";
 	}
+	cout << endl;
+}
 
-	~ZDDNode()
-	{
-		delete[] deg;
-		delete[] comp;
+// 分類ごとのメモリ使用量の現在値と最大値，レベルごとの使用量を標準エラー出力に出力する
+static void PrintMemoryProfile(MemoryProfile* profile)
+{
+	cerr << "memory profile (bytes):";
+	for (int c = 0; c < kNumberOfMemoryCategories; ++c) {
+		MemoryCategory category = static_cast<MemoryCategory>(c);
+		cerr << " " << MemoryProfile::GetCategoryName(category) << " = " << profile->current[c]
+			<< " (peak " << profile->peak[c] << ")" << (c + 1 < kNumberOfMemoryCategories ? "," : "");
 	}
-
-	void SetNextId() // ノードに次のIDを振る
-	{
-		id_ = total_id_;
-		++total_id_;
+	cerr << ", peak total = " << profile->peak_total << endl;
+	for (size_t i = 1; i < profile->levels.size(); ++i) {
+		cerr << "level " << i << ":";
+		int64_t total = 0;
+		for (int c = 0; c < kNumberOfMemoryCategories; ++c) {
+			cerr << " " << MemoryProfile::GetCategoryName(static_cast<MemoryCategory>(c))
+				<< " = " << profile->levels[i][c] << ",";
+			total += profile->levels[i][c];
+		}
+		cerr << " total = " << total << endl;
 	}
+}
 
-	int GetId() // IDを返す
-	{
-		return id_;
+// ZDD を作らずに問い（PathQuery）に答える。見つけたパスは標準出力に1行ずつ出力する
+static int RunQuery(State* state, const string& query, int64_t k)
+{
+	if (query == "exists") {
+		vector<int> path;
+		bool exists = PathQuery::Exists(state, &path);
+		cerr << "s-t path exists = " << (exists ? "yes" : "no") << endl;
+		if (exists) {
+			PrintPath(state->graph, path);
+		}
+	} else if (query == "count-cap") {
+		int64_t count = PathQuery::CountUpTo(state, k);
+		cerr << "# of solutions " << (count >= k ? ">= " : "= ") << count << endl;
+	} else {
+		vector<vector<int> > paths;
+		PathQuery::FindPaths(state, k, &paths);
+		cerr << "# of paths found = " << paths.size() << endl;
+		for (size_t p = 0; p < paths.size(); ++p) {
+			PrintPath(state->graph, paths[p]);
+		}
 	}
+	return 0;
+}
 
-	// 根(root)ノードを作成して返す。
-	// number_of_vertices: 入力グラフの頂点の数
-	static ZDDNode* CreateRootNode(int number_of_vertices)
-	{
-		ZDDNode* node = new ZDDNode();
-		node->SetNextId();
-		node->deg = new int[number_of_vertices + 1];
-		node->comp = new int[number_of_vertices + 1];
-
-		// deg, comp を初期化
-		for (int i = 1; i <= number_of_vertices; ++i)
-		{
-			node->deg[i] = 0;
-			node->comp[i] = i;
+// 辺の順序の候補（"input,bfs,search" のようにカンマで区切る）ごとに，ZDD を作らずに
+// フロンティアの大きさとノード数を見積もる。各レベルの値は標準出力に出力する
+static int RunPlan(Graph* graph, const vector<std::pair<int, int> >& pairs,
+	const vector<int>& fixed_edges, const string& orders, int beam_width, int walks,
+	const EdgeOrderSearchOptions& search_options)
+{
+	std::istringstream iss(orders);
+	string order;
+	while (std::getline(iss, order, ',')) {
+		vector<Edge> edge_list;
+		vector<int> permutation;
+		if (!FrontierPlanner::MakeEdgeOrder(graph, 1, order, &edge_list, &permutation,
+				search_options)) {
+			PrintUsage();
+			return 1;
+		}
+		Graph ordered;
+		ordered.SetDirected(graph->IsDirected());
+		ordered.SetEdgeList(graph->GetNumberOfVertices(), edge_list);
+		State state(&ordered, pairs);
+		for (size_t e = 0; e < fixed_edges.size(); ++e) { // 辺の固定を並べ替えた順序に写す
+			state.fixed_edges.push_back(fixed_edges[permutation[e]]);
+		}
+		FrontierPlan plan;
+		FrontierPlanner::Estimate(&state, beam_width, walks, 1, &plan);
+
+		cerr << "order = " << order << ": # of levels = " << plan.number_of_levels
+			<< ", max width = " << plan.max_width << ", average width = " << plan.average_width;
+		if (beam_width > 0) {
+			cerr << ", estimated # of nodes = " << plan.total_nodes
+				<< (plan.exact ? " (exact)" : "");
+		}
+		cerr << endl;
+		cout << "# order = " << order << endl;
+		for (int i = 1; i <= plan.number_of_levels; ++i) {
+			cout << i << " " << plan.width[i];
+			if (beam_width > 0) {
+				cout << " " << plan.nodes[i];
+			}
+			if (walks > 0) {
+				cout << " " << plan.paths[i];
+			}
+			cout << endl;
 		}
-		return node;
 	}
+	return 0;
+}
 
-	// ZDDノードをコピーして返す。
-	// number_of_vertices: 入力グラフの頂点の数
-	ZDDNode* MakeCopy(int number_of_vertices)
-	{
-		ZDDNode* node = new ZDDNode();
-		node->deg = new int[number_of_vertices + 1];
-		node->comp = new int[number_of_vertices + 1];
-
-		// deg, comp 配列をコピー
-		for (int i = 1; i <= number_of_vertices; ++i)
-		{
-			node->deg[i] = deg[i];
-			node->comp[i] = comp[i];
+// 端点の組 "s1:t1,s2:t2,..." を読み取る。形式が不正なら false を返す
+static bool ParsePairs(const string& text, vector<std::pair<int, int> >* pairs)
+{
+	std::istringstream iss(text);
+	string item;
+	while (std::getline(iss, item, ',')) {
+		int s, t;
+		char colon, rest;
+		std::istringstream item_iss(item);
+		if (!(item_iss >> s >> colon >> t) || colon != ':' || item_iss >> rest) {
+			return false;
 		}
-		return node;
+		pairs->push_back(std::make_pair(s, t));
 	}
+	return !pairs->empty();
+}
 
-	// ノードに子を設定
-	// child_num: 0 なら0枝側の子として node を設定
-	// 1 なら1枝側の子として node を設定
-	void SetChild(ZDDNode* node, int child_num)
-	{
-		if (child_num == 0)
-		{
-			zero_child = node;
-		}
-		else
-		{
-			one_child = node;
+// 辺の番号（1始まり）の並び "e1,e2,..." を読み取り，fixed[e - 1] = value とする。
+// 形式が不正なら false を返す（番号が辺の数以下かは後で調べる）
+static bool ParseFixedEdges(const string& text, int value, vector<std::pair<int, int> >* fixed)
+{
+	std::istringstream iss(text);
+	string item;
+	while (std::getline(iss, item, ',')) {
+		int e;
+		char rest;
+		std::istringstream item_iss(item);
+		if (!(item_iss >> e) || e < 1 || item_iss >> rest) {
+			return false;
 		}
+		fixed->push_back(std::make_pair(e, value));
 	}
+	return true;
+}
 
-	// ノードの子ノードを取得
-	// child_num: 0 なら0枝側の子を取得
-	// 1 なら1枝側の子を取得
-	ZDDNode* GetChild(int child_num)
-	{
-		if (child_num == 0)
-		{
-			return zero_child;
+// 重みベクトルのファイルを読み込む。1行が1つの重みベクトルで，辺の数だけの数を
+// 空白区切りで並べる（空行と '#' で始まる行は読み飛ばす）。
+// 開けない，または数の個数が number_of_edges でない行があれば false を返す
+static bool ReadWeights(const string& filename, size_t number_of_edges,
+	vector<vector<double> >* weights)
+{
+	std::ifstream ifs(filename.c_str());
+	if (!ifs) {
+		return false;
+	}
+	string line;
+	while (std::getline(ifs, line)) {
+		std::istringstream iss(line);
+		vector<double> w;
+		double x;
+		while (iss >> x) {
+			w.push_back(x);
 		}
-		else
-		{
-			return one_child;
+		char c;
+		std::istringstream head(line);
+		if (!(head >> c) || c == '#') {
+			continue;
 		}
+		if (!iss.eof() || w.size() != number_of_edges) {
+			return false;
+		}
+		weights->push_back(w);
 	}
+	return true;
+}
 
-	// ZDDノードを文字列にして返す
-	string ToString()
-	{
-		ostringstream oss;
-		oss << id_;
-
-		if (id_ >= 2)
-		{
-			oss << ":" << zero_child->id_ << "," << one_child->id_;
+// 前処理（ReduceGraph）をしてから，各核の ZDD を構築する。各核の ZDD を元の辺を変数とする
+// ZDDManager の ZDD に戻して（ExpandReducedGraph）つなぎ合わせ，元のグラフの s-t パスの族として
+// 出力する（ノードは既約にしたもの）。端点の組は1組（s, t）でなければならない
+static int RunReduced(Graph* graph, int s, int t, const string& algorithm,
+	const ConstructOptions& options, int num_threads)
+{
+	ReducedGraph reduced;
+	ReduceGraph(graph, s, t, &reduced);
+	cerr << "# of cores = " << reduced.cores.size()
+		<< ", # of forced edges = " << reduced.forced_edges.size()
+		<< ", # of removed edges = " << reduced.number_of_removed_edges
+		<< ", # of contracted vertices = " << reduced.number_of_contracted_vertices << endl;
+
+	vector<ZDD*> zdds;
+	for (size_t k = 0; k < reduced.cores.size(); ++k) {
+		ReducedCore& core = reduced.cores[k];
+		State state(&core.graph, core.s, core.t);
+		ZDD* zdd = ConstructByName(algorithm, &state, options);
+		if (zdd == NULL) {
+			for (size_t j = 0; j < zdds.size(); ++j) {
+				delete zdds[j];
+			}
+			PrintUsage();
+			return 1;
 		}
-		return oss.str();
+		cerr << "core " << k + 1 << ": # of vertices = " << core.graph.GetNumberOfVertices()
+			<< ", # of edges = " << core.graph.GetEdgeList().size()
+			<< ", # of nodes = " << zdd->GetNumberOfNodes()
+			<< ", # of solutions = " << zdd->GetNumberOfSolutions(num_threads) << endl;
+		zdds.push_back(zdd);
 	}
-};
 
-int ZDDNode::total_id_ = 2;
-ZDDNode* ZDDNode::ZeroTerminal = NULL;
-ZDDNode* ZDDNode::OneTerminal = NULL;
-ZDDNode ZDDNode::zero_t_;
-ZDDNode ZDDNode::one_t_;
+	ZDDManager manager(static_cast<int>(graph->GetEdgeList().size()));
+	ZDDManager::NodeId f = ExpandReducedGraph(reduced, zdds, &manager);
+	for (size_t k = 0; k < zdds.size(); ++k) {
+		delete zdds[k];
+	}
+	cerr << "# of nodes of ZDD = " << manager.GetNumberOfNodes(f);
+	cerr << ", # of solutions = " << manager.Count(f) << endl;
+	cout << manager.ToString(f);
+	return 0;
+}
 
 //******************************************************************************
-// State 構造体
+// サーバモード（-server）
+//
+// 要求を1行ずつ読み，ワーカースレッドで並行に処理して，応答を1行ずつ返す。要求の形式は
+//   <id> <問い> <グラフのファイル> [<s> <t>]
+// で（s, t を省略すると 1 と頂点の数），問いは count（ZDD を構築して解の個数を数える），
+// exists, count-cap:K, paths:k のいずれか。応答は "<id> ok ..." または "<id> error <理由>" で，
+// 処理の終わった順に返す（id で要求と対応づける）。パスは辺の番号（1始まり）をカンマで区切って表す。
+// ワーカースレッドと，読み込んだグラフ（ファイルの更新時刻と大きさが変わらない間），
+// ワーカーごとの packed の状態表（ConstructWorkspace）は要求をまたいで使い回す。
+
+// 応答の書き出し先（標準出力，またはソケットの接続1つ）。
+// 1行ずつまとめて書くので，複数のワーカーの応答が混ざることはない。
+// close_fd なら，最後の参照がなくなったとき（読み込みが終わり，応答をすべて書いたとき）に閉じる
+class ServerOutput {
+private:
+	std::mutex mutex_;
+	int fd_;
+	bool close_fd_;
 
-class State
-{
 public:
-	Graph* graph; // 入力グラフ
-	int s; // s-tパスの始点の頂点番号
-	int t; // s-tパスの始点の頂点番号
-	vector<int>** F; // フロンティアを格納する2次元配列
+	ServerOutput(int fd, bool close_fd)
+	{
+		fd_ = fd;
+		close_fd_ = close_fd;
+	}
 
-public:
-	State(Graph* g, int start, int end)
+	~ServerOutput()
 	{
-		s = start;
-		t = end;
-		graph = g;
-		ComputeFrontier();
+		if (close_fd_) {
+			close(fd_);
+		}
 	}
 
-	~State()
+	void WriteLine(const string& line)
 	{
-		for (size_t i = 0; i < graph->GetEdgeList().size() + 1; ++i) {
-			delete F[i];
+		std::lock_guard<std::mutex> lock(mutex_);
+		string text = line + "\n";
+		size_t written = 0;
+		while (written < text.size()) {
+			ssize_t n = write(fd_, text.data() + written, text.size() - written);
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) { // 相手が接続を閉じた
+				return;
+			}
+			written += static_cast<size_t>(n);
 		}
-		delete[] F;
 	}
+};
 
+class Server {
 private:
-	void ComputeFrontier() // フロンティアの計算
-	{
-		const vector<Edge>& edge_list = graph->GetEdgeList();
+	struct Request {
+		string line;
+		std::shared_ptr<ServerOutput> output;
+	};
 
-		F = new vector<int>*[edge_list.size() + 1];
-		F[0] = new vector<int>;
+	struct CachedGraph {
+		int64_t mtime; // ファイルの更新時刻（ナノ秒）
+		int64_t size;  // ファイルの大きさ
+		std::shared_ptr<Graph> graph;
+	};
 
-		for (size_t i = 0; i < edge_list.size(); ++i)
-		{
-			F[i + 1] = new vector<int>;
-			// i 番目のフロンティア配列の要素すべてを，i + 1 番目のフロンティア配列に追加する
-			for (size_t j = 0; j < F[i]->size(); ++j) {
-				F[i + 1]->push_back((*F[i])[j]);
-			}
+	// これより多くのグラフを読み込んだら，覚えているグラフを捨てる
+	static const size_t kMaxCachedGraphs = 64;
 
-			Edge edge = edge_list[i];
-			int src = edge.src;
-			int dest = edge.dest;
+	string algorithm_;
+	ConstructOptions options_;
+	GraphFormat format_;
+	bool directed_;
 
-			// i + 1 番目のフロンティア配列に src が含まれない（重複チェック）
-			if (!Contains(*F[i + 1], src))
-			{
-				// i + 1 番目のフロンティア配列に src を追加
-				F[i + 1]->push_back(src);
-			}
-			// dest に対しても同様の処理
-			if (!Contains(*F[i + 1], dest))
-			{
-				F[i + 1]->push_back(dest);
-			}
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	std::deque<Request> queue_;
+	bool closed_; // これ以上要求が来ない
 
-			// i + 1 番目以降の辺に，頂点 src が出現しないかどうかチェック。
-			// 出現しないなら，i + 1 番目のフロンティアから src が去るので，
-			// src を削除する。
-			if (!FindElement(i, src))
-			{
-				// src を削除
-				Remove(F[i + 1], src);
-			}
-			// dest に対しても同様の処理
-			if (!FindElement(i, dest))
-			{
-				Remove(F[i + 1], dest);
-			}
-		}
+	std::mutex graph_mutex_;
+	std::map<string, CachedGraph> graphs_;
+
+	vector<std::thread> workers_;
+
+public:
+	Server(const string& algorithm, const ConstructOptions& options, GraphFormat format,
+		bool directed)
+	{
+		algorithm_ = algorithm;
+		options_ = options;
+		format_ = format;
+		directed_ = directed;
+		closed_ = false;
 	}
 
-	// i + 1 番目以降の辺に，頂点 src が出現しないかどうかチェック。
-	// 出現するなら true を，しないなら false を返す。
-	bool FindElement(int edge_number, int value)
+	// num_workers 個のワーカースレッドを起動する
+	void Start(int num_workers)
 	{
-		const vector<Edge>& edge_list = graph->GetEdgeList();
-		for (size_t i = edge_number + 1; i < edge_list.size(); ++i)
-		{
-			if (value == edge_list[i].src || value == edge_list[i].dest)
-			{
-				return true;
-			}
+		for (int k = 0; k < num_workers; ++k) {
+			workers_.push_back(std::thread([this] { WorkerLoop(); }));
 		}
-		return false;
 	}
-};
 
-//******************************************************************************
-// ZDD 構造体
-// ZDD のノードが node_list_array_ に格納される。
-// レベル i のノードは (*node_list_array_)[i] に格納される。
-// i は1始まり。0は使わない。i = m + 1 はダミー。
-// レベル i の j 番目のノードは (*node_list_array)[i][j] で参照できる。
-class ZDD
-{
-private:
-	vector<vector<ZDDNode*> >* node_list_array_;
-
-public:
-	ZDD(vector<vector<ZDDNode*> >* node_list_array)
+	void Push(const string& line, const std::shared_ptr<ServerOutput>& output)
 	{
-		node_list_array_ = node_list_array;
+		Request request;
+		request.line = line;
+		request.output = output;
+		std::lock_guard<std::mutex> lock(mutex_);
+		queue_.push_back(request);
+		cond_.notify_one();
 	}
 
-	~ZDD()
+	// fd から要求を1行ずつ読んで（fd の終わりまで）キューに入れる
+	void Read(int fd, const std::shared_ptr<ServerOutput>& output)
 	{
-		for (size_t i = 0; i < node_list_array_->size(); ++i) {
-			for (size_t j = 0; j < (*node_list_array_)[i].size(); ++j) {
-				delete (*node_list_array_)[i][j];
+		string pending;
+		char buffer[4096];
+		for (;;) {
+			ssize_t n = read(fd, buffer, sizeof(buffer));
+			if (n < 0 && errno == EINTR) {
+				continue;
 			}
+			if (n <= 0) {
+				break;
+			}
+			pending.append(buffer, static_cast<size_t>(n));
+			size_t pos;
+			while ((pos = pending.find('\n')) != string::npos) {
+				Push(pending.substr(0, pos), output);
+				pending.erase(0, pos + 1);
+			}
+		}
+		if (!pending.empty()) {
+			Push(pending, output);
 		}
-		delete node_list_array_;
 	}
 
-	// ZDDのノード数を返す
-	int64_t GetNumberOfNodes()
+	// キューに入れた要求をすべて処理し終えるまで待ち，ワーカースレッドを終了させる
+	void Finish()
 	{
-		int64_t num = 0;
-		for (size_t i = 1; i < node_list_array_->size(); ++i)
 		{
-			num += static_cast<int64_t>((*node_list_array_)[i].size());
+			std::lock_guard<std::mutex> lock(mutex_);
+			closed_ = true;
+			cond_.notify_all();
 		}
-		return num + 2; // + 2 は終端ノードの分
+		for (size_t k = 0; k < workers_.size(); ++k) {
+			workers_[k].join();
+		}
+		workers_.clear();
 	}
 
-	// ZDDが表現する集合族の大きさ（解の個数）を返す
-	int64_t GetNumberOfSolutions()
+private:
+	void WorkerLoop()
 	{
-		ZDDNode::ZeroTerminal->sol = 0;
-		ZDDNode::OneTerminal->sol = 1;
-
-		// 動的計画法による解の個数の計算。
-		// 0枝側のノードの解の個数と，1枝側のノードの解の個数を足したものが，
-		// そのノードの解の個数になる。
-		// レベルが高いノードから低いノードに向けて計算する
-		for (int i = static_cast<int>(node_list_array_->size()) - 1; i >= 1; --i)
-		{
-			for (size_t j = 0; j < (*node_list_array_)[i].size(); ++j)
+		ConstructWorkspace workspace; // このワーカーの count で使い回す状態表
+		for (;;) {
+			Request request;
 			{
-				// 0枝側の子ノード
-				ZDDNode* lo_node = (*node_list_array_)[i][j]->GetChild(0);
-				// 1枝側の子ノード
-				ZDDNode* hi_node = (*node_list_array_)[i][j]->GetChild(1);
-				(*node_list_array_)[i][j]->sol = lo_node->sol + hi_node->sol;
+				std::unique_lock<std::mutex> lock(mutex_);
+				cond_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+				if (queue_.empty()) {
+					return;
+				}
+				request = queue_.front();
+				queue_.pop_front();
+			}
+			string response = Handle(request.line, &workspace);
+			if (!response.empty()) {
+				request.output->WriteLine(response);
 			}
 		}
-		return (*node_list_array_)[1][0]->sol;
 	}
 
-	// ZDDを文字列にして返す
-	string GetZDDString()
+	// path のグラフを graph に格納する（覚えていれば読み込まずに写す）。開けなければ false を返す
+	bool GetGraph(const string& path, Graph* graph)
 	{
-		ostringstream oss;
-
-		for (size_t i = 1; i < node_list_array_->size() - 1; ++i) {
-			oss << "#" << i << "\r\n";
-			for (size_t j = 0; j < (*node_list_array_)[i].size(); ++j) {
-				oss << (*node_list_array_)[i][j]->ToString() << "\r\n";
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) {
+			return false;
+		}
+		int64_t mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000
+			+ st.st_mtim.tv_nsec;
+		int64_t size = static_cast<int64_t>(st.st_size);
+		{
+			std::lock_guard<std::mutex> lock(graph_mutex_);
+			std::map<string, CachedGraph>::iterator it = graphs_.find(path);
+			if (it != graphs_.end() && it->second.mtime == mtime && it->second.size == size) {
+				*graph = *it->second.graph;
+				return true;
 			}
 		}
-		return oss.str();
+		std::shared_ptr<Graph> loaded(new Graph());
+		loaded->SetDirected(directed_);
+		if (!loaded->LoadFile(path, format_)) {
+			return false;
+		}
+		*graph = *loaded;
+		std::lock_guard<std::mutex> lock(graph_mutex_);
+		if (graphs_.size() >= kMaxCachedGraphs) {
+			graphs_.clear();
+		}
+		CachedGraph& cached = graphs_[path];
+		cached.mtime = mtime;
+		cached.size = size;
+		cached.graph = loaded;
+		return true;
 	}
-};
-
-//******************************************************************************
-// アルゴリズム本体
 
-class FrontierAlgorithm {
-
-public:
-	// フロンティア法を実行し，ZDDを作成して返す
-	// アルゴリズムの中身については文献参照
-	static ZDD* Construct(State* state)
+	static void AppendPath(const vector<int>& path, std::ostringstream* out)
 	{
-		const vector<Edge>& edge_list = state->graph->GetEdgeList();
-		// 生成したノードを格納する配列
-		vector<vector <ZDDNode*> >* N = new vector<vector <ZDDNode*> >(edge_list.size() + 2);
-		// 根ノードを作成して N[1] に追加
-		(*N)[1].push_back(ZDDNode::CreateRootNode(state->graph->GetNumberOfVertices()));
-
-		for (size_t i = 1; i <= edge_list.size(); ++i) { // 各辺 i についての処理
-			for (size_t j = 0; j < (*N)[i].size(); ++j) { // レベル i の各ノードについての処理
-				ZDDNode* n_hat = (*N)[i][j]; // レベル i の j 番目のノード
-				for (int x = 0; x <= 1; ++x) { // x枝（x = 0, 1）についての処理
-					ZDDNode* n_prime = CheckTerminal(n_hat, i, x, state);
-
-					if (n_prime == NULL) { // x枝の先が0終端でも1終端でもないと判定された
-						n_prime = n_hat->MakeCopy(state->graph->GetNumberOfVertices());
-						UpdateInfo(n_prime, i, x, state);
-						ZDDNode* n_primeprime = Find(n_prime, (*N)[i + 1], i, state);
-						if (n_primeprime != NULL)
-						{
-							delete n_prime; // n_prime を破棄
-							n_prime = n_primeprime;
-						}
-						else
-						{
-							n_prime->SetNextId();
-							(*N)[i + 1].push_back(n_prime);
-						}
-					}
-					n_hat->SetChild(n_prime, x);
-				}
-			}
+		*out << " path=";
+		for (size_t k = 0; k < path.size(); ++k) {
+			*out << (k > 0 ? "," : "") << path[k] + 1;
 		}
-		return new ZDD(N);
 	}
 
-private:
-	// アルゴリズムの中身については文献参照
-	static ZDDNode* CheckTerminal(ZDDNode* n_hat, int i, int x, State* state)
+	// 要求 line を処理して応答を返す（空行なら空文字列を返す）。
+	// count の構築には workspace の状態表を使う
+	string Handle(const string& line, ConstructWorkspace* workspace)
 	{
-		Edge edge = state->graph->GetEdgeList()[i - 1];
-		if (x == 1)
-		{
-			if (n_hat->comp[edge.src] == n_hat->comp[edge.dest])
-			{
-				return ZDDNode::ZeroTerminal;
-			}
+		std::istringstream iss(line);
+		string id, query, path;
+		if (!(iss >> id)) {
+			return "";
 		}
-		ZDDNode* n_prime = n_hat->MakeCopy(state->graph->GetNumberOfVertices());
-		UpdateInfo(n_prime, i, x, state);
-
-		for (int y = 0; y <= 1; ++y)
-		{
-			int u = (y == 0 ? edge.src : edge.dest);
-			if ((u == state->s || u == state->t) && n_prime->deg[u] > 1)
-			{
-				delete n_prime;
-				return ZDDNode::ZeroTerminal;
-			}
-			else if ((u != state->s && u != state->t) && n_prime->deg[u] > 2)
-			{
-				delete n_prime;
-				return ZDDNode::ZeroTerminal;
+		if (!(iss >> query >> path)) {
+			return id + " error invalid request";
+		}
+		int s = 1, t = 0;
+		string rest;
+		if (iss >> s) {
+			if (!(iss >> t) || iss >> rest) {
+				return id + " error invalid request";
 			}
+		} else if (!iss.eof()) {
+			return id + " error invalid request";
 		}
-		for (int y = 0; y <= 1; ++y)
-		{
-			int u = (y == 0 ? edge.src : edge.dest);
-			if (!Contains(*state->F[i], u))
-			{
-				if ((u == state->s || u == state->t) && n_prime->deg[u] != 1)
-				{
-					delete n_prime;
-					return ZDDNode::ZeroTerminal;
-				}
-				else if ((u != state->s && u != state->t) && n_prime->deg[u] != 0 && n_prime->deg[u] != 2)
-				{
-					delete n_prime;
-					return ZDDNode::ZeroTerminal;
-				}
+
+		// 問いの名前と K（count-cap:K, paths:k）
+		string name = query.substr(0, query.find(':'));
+		int64_t k = 0;
+		if (name.size() < query.size()) {
+			const char* text = query.c_str() + name.size() + 1;
+			char* end;
+			errno = 0;
+			k = std::strtoll(text, &end, 10);
+			if (end == text || *end != '\0' || errno == ERANGE) { // 数でないか，後ろに余計な文字がある
+				return id + " error invalid query " + query;
 			}
 		}
-		if (i == static_cast<int>(state->graph->GetEdgeList().size()))
-		{
-			delete n_prime;
-			return ZDDNode::OneTerminal;
+		if (!((name == "count" || name == "exists") && name.size() == query.size())
+			&& !((name == "count-cap" || name == "paths") && k >= 1)) {
+			return id + " error invalid query " + query;
 		}
-		delete n_prime;
-		return NULL;
-	}
 
-	// アルゴリズムの中身については文献参照
-	static void UpdateInfo(ZDDNode* n_hat, int i, int x, State* state)
-	{
-		Edge edge = state->graph->GetEdgeList()[i - 1];
-		for (int y = 0; y <= 1; ++y)
-		{
-			int u = (y == 0 ? edge.src : edge.dest);
-			if (!Contains(*state->F[i - 1], u))
-			{
-				n_hat->deg[u] = 0;
-				n_hat->comp[u] = u;
+		Graph graph;
+		if (!GetGraph(path, &graph)) {
+			return id + " error cannot open " + path;
+		}
+		if (t == 0) {
+			t = graph.GetNumberOfVertices();
+		}
+		if (s < 1 || t < 1 || s > graph.GetNumberOfVertices() || t > graph.GetNumberOfVertices()
+			|| s == t || graph.GetEdgeList().empty()) {
+			return id + " error invalid terminals";
+		}
+		State state(&graph, s, t);
+
+		std::ostringstream out;
+		out << id << " ok";
+		if (name == "count") {
+			ConstructReport report;
+			ConstructOptions options = options_;
+			options.report = &report;
+			options.workspace = workspace;
+			ZDD* zdd = ConstructByName(algorithm_, &state, options);
+			if (zdd != NULL) {
+				out << " nodes=" << zdd->GetNumberOfNodes()
+					<< " solutions=" << zdd->GetNumberOfSolutions();
+				delete zdd;
+			} else if (report.fallback != kFallbackNone && report.number_of_solutions >= 0) {
+				out << " solutions=" << report.number_of_solutions; // 解の個数だけを数えた
+			} else {
+				return id + " error construction failed";
+			}
+		} else if (name == "exists") {
+			vector<int> found;
+			bool exists = PathQuery::Exists(&state, &found);
+			out << " exists=" << (exists ? "yes" : "no");
+			if (exists) {
+				AppendPath(found, &out);
+			}
+		} else if (name == "count-cap") {
+			int64_t count = PathQuery::CountUpTo(&state, k);
+			out << " solutions" << (count >= k ? ">=" : "=") << count;
+		} else {
+			vector<vector<int> > paths;
+			PathQuery::FindPaths(&state, k, &paths);
+			out << " paths=" << paths.size();
+			for (size_t p = 0; p < paths.size(); ++p) {
+				AppendPath(paths[p], &out);
 			}
 		}
-		if (x == 1)
-		{
-			++n_hat->deg[edge.src];
-			++n_hat->deg[edge.dest];
-			int c_min = std::min(n_hat->comp[edge.src], n_hat->comp[edge.dest]);
-			int c_max = std::max(n_hat->comp[edge.src], n_hat->comp[edge.dest]);
+		return out.str();
+	}
+};
 
+// サーバモードを実行する。socket_path が空なら標準入力から要求を読み，
+// 標準入力の終わりで（すべての要求に応答してから）終了する。
+// 空でなければ Unix ドメインソケット socket_path で接続を待ち，接続ごとに要求を読む（終了しない）
+static int RunServer(const string& algorithm, const ConstructOptions& options, GraphFormat format,
+	bool directed, int num_workers, const string& socket_path)
+{
+	signal(SIGPIPE, SIG_IGN); // 接続を閉じた相手への書き込みで終了しないようにする
+	Server* server = new Server(algorithm, options, format, directed);
+	server->Start(num_workers);
+
+	if (socket_path.empty()) {
+		server->Read(0, std::make_shared<ServerOutput>(1, false));
+		server->Finish();
+		delete server;
+		return 0;
+	}
 
-			for (size_t j = 0; j < state->F[i]->size(); ++j)
-			{
-				int u = (*state->F[i])[j];
-				if (n_hat->comp[u] == c_max)
-				{
-					n_hat->comp[u] = c_min;
-				}
+	struct sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(address.sun_path)) {
+		cerr << "socket path too long: " << socket_path << endl;
+		return 1;
+	}
+	std::strcpy(address.sun_path, socket_path.c_str());
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socket_path.c_str());
+	if (listener < 0 || bind(listener, reinterpret_cast<struct sockaddr*>(&address),
+			sizeof(address)) != 0 || listen(listener, 64) != 0) {
+		cerr << "cannot listen on " << socket_path << endl;
+		return 1;
+	}
+	cerr << "listening on " << socket_path << " with " << num_workers << " workers" << endl;
+	// 接続ごとに読み込み用のスレッドを立てる。サーバは終了しないので server は解放しない
+	for (;;) {
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
 			}
+			cerr << "accept failed on " << socket_path << endl;
+			return 1;
 		}
+		std::thread([server, fd] {
+			server->Read(fd, std::make_shared<ServerOutput>(fd, true));
+		}).detach();
 	}
+}
 
-	// ノード配列 N_i の中に，n_prime と等価なノードが存在するか調べる。
-	// 等価なノードが存在すればそれを返す。存在しなければ NULL を返す。
-	// i: レベル
-	static ZDDNode* Find(ZDDNode* n_prime, const vector<ZDDNode*>& N_i, int i, State* state)
-	{
-		for (unsigned int j = 0; j < N_i.size(); ++j) {
-			ZDDNode* n_primeprime = N_i[j];
-		
-			// n_prime と n_primeprime が等価かどうか判定
-			if (IsEquivalent(n_prime, n_primeprime, i, state))
-			{
-				return n_primeprime;
+int main(int argc, char** argv)
+{
+	string algorithm = "frontier"; // 使用するアルゴリズム（frontier, simpath, packed）
+	ConstructOptions options; // packed の設定（SIMD 命令セット，チェックポイント）
+	bool reduce = false; // 前処理をしてから構築するか
+	bool directed = false; // 有向グラフとして読み込むか
+	vector<std::pair<int, int> > pairs; // 端点の組（空なら (1, 頂点の数) の1組）
+	vector<std::pair<int, int> > filters; // 構築後に絞り込む (辺の番号, 1: 含む / 0: 含まない)
+	vector<std::pair<int, int> > fixed; // 構築中に固定する (辺の番号, 1: 使う / 0: 使わない)
+	vector<std::pair<int, int> > deleted; // 構築後に削除する (辺の番号, 0)
+	string input_file; // 入力グラフのファイル（空なら標準入力）
+	GraphFormat format = kGraphFormatAuto; // 入力グラフの形式（標準入力では既定は隣接リスト）
+	string query; // ZDD を作らずに答える問い（exists, count-cap, paths）。空なら ZDD を作る
+	int64_t query_k = 0; // count-cap の K，paths の k
+	string plan_orders; // 見積もる辺の順序の候補（空なら見積もらない）
+	int plan_beam_width = 10000; // 見積もりで各レベルに残す状態の数
+	int plan_walks = 1000; // 見積もりの無作為歩行の回数
+	string weights_file; // 解の重みの和を求める重みベクトルのファイル（空なら求めない）
+	bool maximize = false; // 重みの和の最小値ではなく最大値を求めるか
+	int approx_beam_width = 0; // 近似数え上げで各レベルに残す状態の数（0 なら近似しない）
+	int approx_replicates = 10; // 近似数え上げの反復の回数
+	uint64_t approx_seed = 1; // 近似数え上げの乱数の種
+	string edge_order; // 構築に用いる辺の順序（input, bfs, search）。空なら入力のまま
+	EdgeOrderSearchOptions search_options; // 辺の順序の探索（search）の設定
+	search_options.num_threads = 0; // 0 なら num_threads と同じにする
+	bool memory_profile = false; // 分類ごと・レベルごとのメモリ使用量を出力するか
+	bool renumber = false; // 構築した ZDD を ZDD::Renumber で並べ替えてから用いるか
+	bool spill_directory_set = false; // -spill-dir を指定したか
+	bool export_zdd = false; // ZDD を export_format の形式で出力するか
+	ZDDFormat export_format = kFormatSapporo;
+	bool server = false; // サーバモードで要求を読み続けるか
+	string server_socket; // サーバモードで接続を待つ Unix ドメインソケット（空なら標準入力）
+	// サーバモードで要求を並行に処理するワーカースレッドの数
+	int server_workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	int verify_graphs = 0; // 差分検証で調べるグラフの数（0 なら検証しない）
+	int verify_vertices = 8; // 差分検証のグラフの頂点の数の最大値
+	uint64_t verify_seed = 1; // 差分検証の乱数の種
+	string verify_c_program; // 差分検証で比べる C 版のプログラム（空なら比べない）
+	// 解の個数の計算に用いるスレッド数
+	int num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	for (int k = 1; k < argc; ++k) {
+		string arg = argv[k];
+		if (arg == "-a" && k + 1 < argc) {
+			algorithm = argv[++k];
+		} else if (arg == "-simd" && k + 1 < argc) {
+			string name = argv[++k];
+			SimdLevel level = (name == "avx2" ? kSimdAvx2 : (name == "sse2" ? kSimdSse2 : kSimdScalar));
+			if (name != GetSimdLevelName(level)) {
+				PrintUsage();
+				return 1;
+			}
+			options.simd = std::min(options.simd, level); // CPU が対応していない命令セットは使わない
+		} else if (arg == "-threads" && k + 1 < argc) {
+			num_threads = std::max(1, std::atoi(argv[++k]));
+		} else if (arg == "-checkpoint" && k + 1 < argc) {
+			options.checkpoint_directory = argv[++k];
+		} else if (arg == "-checkpoint-interval" && k + 1 < argc) {
+			options.checkpoint_interval = std::atof(argv[++k]);
+		} else if (arg == "-resume") {
+			options.resume = true;
+		} else if (arg == "-processes" && k + 1 < argc) {
+			options.num_processes = std::max(1, std::atoi(argv[++k]));
+		} else if (arg == "-shard-dir" && k + 1 < argc) {
+			options.shard_directory = argv[++k];
+		} else if (arg == "-i" && k + 1 < argc) {
+			input_file = argv[++k];
+		} else if (arg == "-f" && k + 1 < argc) {
+			string name = argv[++k];
+			if (name == "adj") {
+				format = kGraphFormatAdjList;
+			} else if (name == "edge") {
+				format = kGraphFormatEdgeList;
+			} else if (name == "dimacs") {
+				format = kGraphFormatDimacs;
+			} else {
+				PrintUsage();
+				return 1;
 			}
+		} else if (arg == "-memory-budget" && k + 1 < argc) {
+			options.memory_budget = static_cast<int64_t>(std::atof(argv[++k]) * 1024 * 1024);
+		} else if (arg == "-spill-dir" && k + 1 < argc) {
+			options.spill_directory = argv[++k];
+			spill_directory_set = true;
+		} else if (arg == "-exists") {
+			query = "exists";
+		} else if ((arg == "-count-cap" || arg == "-paths") && k + 1 < argc) {
+			query = arg.substr(1);
+			query_k = std::atoll(argv[++k]);
+			if (query_k < 1) {
+				PrintUsage();
+				return 1;
+			}
+		} else if (arg == "-plan" && k + 1 < argc) {
+			plan_orders = argv[++k];
+		} else if (arg == "-plan-beam" && k + 1 < argc) {
+			plan_beam_width = std::max(0, std::atoi(argv[++k]));
+		} else if (arg == "-plan-walks" && k + 1 < argc) {
+			plan_walks = std::max(0, std::atoi(argv[++k]));
+		} else if (arg == "-pairs" && k + 1 < argc) {
+			if (!ParsePairs(argv[++k], &pairs)) {
+				PrintUsage();
+				return 1;
+			}
+		} else if ((arg == "-onset" || arg == "-offset") && k + 1 < argc) {
+			int e = std::atoi(argv[++k]);
+			if (e < 1) {
+				PrintUsage();
+				return 1;
+			}
+			filters.push_back(std::make_pair(e, arg == "-onset" ? 1 : 0));
+		} else if ((arg == "-include" || arg == "-exclude") && k + 1 < argc) {
+			if (!ParseFixedEdges(argv[++k], arg == "-include" ? 1 : 0, &fixed)) {
+				PrintUsage();
+				return 1;
+			}
+		} else if (arg == "-delete" && k + 1 < argc) {
+			if (!ParseFixedEdges(argv[++k], 0, &deleted)) {
+				PrintUsage();
+				return 1;
+			}
+		} else if (arg == "-weights" && k + 1 < argc) {
+			weights_file = argv[++k];
+		} else if (arg == "-maximize") {
+			maximize = true;
+		} else if (arg == "-approx" && k + 1 < argc) {
+			approx_beam_width = std::atoi(argv[++k]);
+			if (approx_beam_width < 1) {
+				PrintUsage();
+				return 1;
+			}
+		} else if (arg == "-approx-replicates" && k + 1 < argc) {
+			approx_replicates = std::max(1, std::atoi(argv[++k]));
+		} else if (arg == "-approx-seed" && k + 1 < argc) {
+			approx_seed = std::strtoull(argv[++k], NULL, 10);
+		} else if (arg == "-order" && k + 1 < argc) {
+			edge_order = argv[++k];
+		} else if (arg == "-order-time" && k + 1 < argc) {
+			search_options.time_limit = std::atof(argv[++k]);
+		} else if (arg == "-order-threads" && k + 1 < argc) {
+			search_options.num_threads = std::max(1, std::atoi(argv[++k]));
+		} else if (arg == "-order-sum") {
+			search_options.minimize_sum = true;
+		} else if (arg == "-memory-profile") {
+			memory_profile = true;
+		} else if (arg == "-renumber") {
+			renumber = true;
+		} else if (arg == "-export" && k + 1 < argc) {
+			if (!ParseZDDFormat(argv[++k], &export_format)) {
+				PrintUsage();
+				return 1;
+			}
+			export_zdd = true;
+		} else if (arg == "-server") {
+			server = true;
+		} else if (arg == "-server-socket" && k + 1 < argc) {
+			server = true;
+			server_socket = argv[++k];
+		} else if (arg == "-server-workers" && k + 1 < argc) {
+			server_workers = std::max(1, std::atoi(argv[++k]));
+		} else if (arg == "-directed") {
+			directed = true;
+		} else if (arg == "-reduce") {
+			reduce = true;
+		} else if (arg == "-verify" && k + 1 < argc) {
+			verify_graphs = std::max(1, std::atoi(argv[++k]));
+		} else if (arg == "-verify-vertices" && k + 1 < argc) {
+			verify_vertices = std::max(0, std::atoi(argv[++k]));
+		} else if (arg == "-verify-seed" && k + 1 < argc) {
+			verify_seed = std::strtoull(argv[++k], NULL, 10);
+		} else if (arg == "-verify-c" && k + 1 < argc) {
+			verify_c_program = argv[++k];
+		} else if (arg == "-bench" && k + 1 < argc) {
+			RunBenchmark(std::atoi(argv[++k]), num_threads);
+			return 0;
+		} else {
+			PrintUsage();
+			return 1;
 		}
-		return NULL;
+	}
+	if (verify_graphs > 0) { // -bench と同じく，-threads 以外の設定は用いない
+		return RunVerify(verify_graphs, verify_vertices, verify_seed, verify_c_program, num_threads);
+	}
+	// チェックポイントと複数プロセスによる構築は packed のみ対応（両者は併用できない）。
+	// メモリ予算（と spill の書き出し先）も packed のみ対応する（サーバモードの count も同じ）。
+	// 有向グラフと端点の組が2組以上のものは packed（と同じ状態表現を用いる問い，見積もり，近似数え上げ）のみ
+	// 対応し，前処理はできない。前処理は辺の番号を振り直すので，辺の固定とも併用できない。
+	// 重みの和は構築した ZDD そのもので求めるので，ZDD を作らない問いや絞り込みとは併用できない
+	// 辺の削除は構築した ZDD を更新するので，ZDD を作らないものとは併用できない。
+	// サーバモードはグラフと問いを要求ごとに受け取り，同じプロセスで並行に処理するので，
+	// それらを指定するオプションや，fork するオプションとは併用できない
+	bool use_processes = options.num_processes > 1;
+	bool packed_only = directed || pairs.size() >= 2;
+	if (((!options.checkpoint_directory.empty() || use_processes) && algorithm != "packed")
+		|| (options.resume && options.checkpoint_directory.empty())
+		|| (use_processes && !options.checkpoint_directory.empty())
+		|| (options.memory_budget > 0 && algorithm != "packed")
+		|| (spill_directory_set && options.memory_budget <= 0)
+		|| (reduce && !fixed.empty())
+		|| (!weights_file.empty() && (reduce || !query.empty() || !plan_orders.empty()
+			|| !filters.empty()))
+		|| (maximize && weights_file.empty())
+		|| (!edge_order.empty() && (reduce || !plan_orders.empty()))
+		|| (approx_beam_width > 0 && (reduce || !plan_orders.empty() || !query.empty()
+			|| !filters.empty() || !weights_file.empty() || server))
+		|| (!deleted.empty() && (reduce || !plan_orders.empty() || !query.empty()
+			|| approx_beam_width > 0 || server))
+		|| (export_zdd && (reduce || !weights_file.empty() || !plan_orders.empty() || !query.empty()
+			|| approx_beam_width > 0 || server))
+		|| (renumber && (reduce || !plan_orders.empty() || !query.empty()
+			|| approx_beam_width > 0 || server))
+		|| (server && (!options.checkpoint_directory.empty() || use_processes || reduce
+			|| !input_file.empty() || !query.empty() || !plan_orders.empty() || !pairs.empty()
+			|| !filters.empty() || !fixed.empty() || !weights_file.empty() || !edge_order.empty()))
+		|| (packed_only && (reduce || (algorithm != "packed" && query.empty() && plan_orders.empty()
+			&& approx_beam_width == 0)))) {
+		PrintUsage();
+		return 1;
+	}
+	if (server) {
+		return RunServer(algorithm, options, format, directed, server_workers, server_socket);
 	}
 
-	// node1 と node2 が等価か調べる。
-	// 等価なら true を，そうでなければ false を返す。
-	// i: レベル
-	static bool IsEquivalent(ZDDNode* node1, ZDDNode* node2, int i, State* state)
-	{
-		vector<int>& frontier = (*state->F[i]);
+	Graph graph;
+	graph.SetDirected(directed);
 
-		for (size_t j = 0; j < frontier.size(); ++j) { // フロンティア上の頂点についてのみ比較
-			int v = frontier[j];
-			if (node1->deg[v] != node2->deg[v]) {
-				return false;
-			}
-			if (node1->comp[v] != node2->comp[v]) {
-				return false;
-			}
+	if (!input_file.empty()) { // ファイルを mmap して読み込む（形式は指定がなければ拡張子で判定）
+		if (!graph.LoadFile(input_file, format)) {
+			cerr << "cannot open " << input_file << endl;
+			return 1;
 		}
-		return true;
+	} else if (format == kGraphFormatAuto || format == kGraphFormatAdjList) {
+		// グラフ（隣接リスト）を標準入力から読み込む
+		graph.ParseAdjListText(cin);
+	} else {
+		string text((std::istreambuf_iterator<char>(cin)), std::istreambuf_iterator<char>());
+		graph.ParseText(text.data(), text.data() + text.size(), format);
 	}
-};
-
-int main()
-{
-	// ZDDNode の初期化（プログラム実行時に1度呼ぶ）
-	ZDDNode::Initialize();
 
-	Graph graph;
+	// State の作成。指定された端点はすべて異なる頂点でなければならない
+	vector<int> terminals;
+	for (size_t k = 0; k < pairs.size(); ++k) {
+		terminals.push_back(pairs[k].first);
+		terminals.push_back(pairs[k].second);
+	}
+	std::sort(terminals.begin(), terminals.end());
+	if (!terminals.empty() && (terminals[0] < 1 || terminals.back() > graph.GetNumberOfVertices()
+		|| std::adjacent_find(terminals.begin(), terminals.end()) != terminals.end())) {
+		cerr << "invalid terminal pairs" << endl;
+		return 1;
+	}
+	if (pairs.empty()) {
+		pairs.push_back(std::make_pair(1, graph.GetNumberOfVertices()));
+	}
+	if (search_options.num_threads == 0) {
+		search_options.num_threads = num_threads;
+	}
 
-	// グラフ（隣接リスト）を標準入力から読み込む
-	graph.ParseAdjListText(cin);
+	// 辺を並べ替える。-include などで指定する辺の番号は入力での番号のままで，
+	// position[e] は入力で e 番目（0始まり）の辺の並べ替えた後の位置
+	vector<int> position(graph.GetEdgeList().size());
+	for (size_t e = 0; e < position.size(); ++e) {
+		position[e] = static_cast<int>(e);
+	}
+	if (!edge_order.empty()) {
+		vector<Edge> edge_list;
+		vector<int> permutation;
+		if (!FrontierPlanner::MakeEdgeOrder(&graph, pairs[0].first, edge_order, &edge_list,
+				&permutation, search_options)) {
+			PrintUsage();
+			return 1;
+		}
+		int before_max, after_max;
+		int64_t before_sum, after_sum;
+		FrontierPlanner::ScoreEdgeOrder(&graph, position, &before_max, &before_sum);
+		FrontierPlanner::ScoreEdgeOrder(&graph, permutation, &after_max, &after_sum);
+		graph.SetEdgeList(graph.GetNumberOfVertices(), edge_list);
+		cerr << "order = " << edge_order << ": max width = " << before_max << " -> " << after_max
+			<< ", sum of widths = " << before_sum << " -> " << after_sum << endl;
+		// ZDD のレベル k は入力で permutation[k - 1] + 1 番目の辺
+		cerr << "edge order =";
+		for (size_t k = 0; k < permutation.size(); ++k) {
+			position[permutation[k]] = static_cast<int>(k);
+			cerr << " " << permutation[k] + 1;
+		}
+		cerr << endl;
+	}
 
-	// State の作成
-	State state(&graph, 1, graph.GetNumberOfVertices());
+	State state(&graph, pairs);
+	if (!fixed.empty()) { // 同じ辺を -include と -exclude の両方に指定したら不正
+		state.fixed_edges.assign(graph.GetEdgeList().size(), -1);
+		for (size_t k = 0; k < fixed.size(); ++k) {
+			int e = fixed[k].first - 1;
+			if (e >= static_cast<int>(graph.GetEdgeList().size())
+				|| state.fixed_edges[position[e]] == 1 - fixed[k].second) {
+				cerr << "invalid fixed edges" << endl;
+				return 1;
+			}
+			state.fixed_edges[position[e]] = fixed[k].second;
+		}
+	}
 
 	// 入力グラフの頂点の数と辺の数を出力
 	cerr << "# of vertices = " << graph.GetNumberOfVertices()
          << ", # of edges = " << graph.GetEdgeList().size() << endl;
 
-	// フロンティア法によるZDD構築
-	ZDD* zdd = FrontierAlgorithm::Construct(&state);
+	if (!plan_orders.empty()) {
+		return RunPlan(&graph, pairs, state.fixed_edges, plan_orders, plan_beam_width, plan_walks,
+			search_options);
+	}
+	if (!query.empty()) {
+		return RunQuery(&state, query, query_k);
+	}
+	if (approx_beam_width > 0) { // ZDD を作らずに解の個数を推定する
+		ApproximateCount result;
+		ApproximateCounter::Count(&state, approx_beam_width, approx_replicates, approx_seed, &result);
+		if (result.exact) {
+			cerr.precision(17); // 2^53 までは整数として正確に出力する
+			cerr << "# of solutions = " << result.estimate << " (exact)" << endl;
+		} else {
+			cerr << "estimated # of solutions = " << result.estimate
+				<< ", 95% confidence interval = [" << result.lower << ", " << result.upper << "]"
+				<< ", standard error = " << result.standard_error
+				<< ", # of replicates = " << result.replicates << endl;
+		}
+		return 0;
+	}
+	if (reduce) {
+		return RunReduced(&graph, pairs[0].first, pairs[0].second, algorithm, options, num_threads);
+	}
+
+	// フロンティア法（または simpath）によるZDD構築
+	ConstructReport report;
+	options.report = &report;
+	MemoryProfile profile;
+	if (memory_profile) {
+		options.profile = &profile;
+	}
+	ZDD* zdd = ConstructByName(algorithm, &state, options);
+	if (algorithm == "packed" && options.memory_budget > 0) {
+		const char* names[] = { "none", "count-only", "spill" };
+		cerr << "estimated peak memory = " << report.peak_memory << " bytes, fallback = "
+			<< names[report.fallback];
+		if (report.fallback != kFallbackNone) {
+			cerr << " (from level " << report.fallback_level;
+			if (report.fallback == kFallbackSpill) {
+				cerr << ", spilled from level " << report.spill_level;
+			}
+			cerr << ")";
+		}
+		cerr << endl;
+	}
+	if (zdd == NULL && algorithm == "packed" && report.fallback != kFallbackNone) {
+		// ZDD を捨てて解の個数だけを数えた
+		if (report.number_of_solutions < 0) {
+			cerr << "cannot write spill files in " << options.spill_directory << endl;
+			return 1;
+		}
+		cerr << "# of solutions = " << report.number_of_solutions << endl;
+		if (memory_profile) { // 切り替える前のレベルまでを出力する
+			PrintMemoryProfile(&profile);
+		}
+		return 0;
+	}
+	if (zdd == NULL) {
+		if (options.resume) {
+			cerr << "cannot resume from " << options.checkpoint_directory << endl;
+		} else if (use_processes) {
+			cerr << "construction with " << options.num_processes << " processes failed" << endl;
+		} else {
+			PrintUsage();
+		}
+		return 1;
+	}
+
+	if (renumber) { // 以後の走査のために各レベルを親の順に並べ替え，子の ID の表を作る
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		zdd->Renumber();
+		cerr << "renumbered in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+			<< " ms" << endl;
+	}
+
+	if (!deleted.empty()) { // 辺を削除したグラフの ZDD に更新する（構築し直さない）
+		cerr << "# of nodes of ZDD = " << zdd->GetNumberOfNodes();
+		cerr << ", # of solutions = " << zdd->GetNumberOfSolutions(num_threads)
+			<< " (before deleting edges)" << endl;
+		vector<int> levels;
+		for (size_t k = 0; k < deleted.size(); ++k) {
+			if (deleted[k].first > static_cast<int>(graph.GetEdgeList().size())) {
+				PrintUsage();
+				delete zdd;
+				return 1;
+			}
+			levels.push_back(position[deleted[k].first - 1] + 1);
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		zdd->DeleteEdges(levels);
+		cerr << "deleted " << deleted.size() << " edges in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+			<< " ms" << endl;
+	}
+
+	if (!filters.empty()) { // 辺 e を含む（含まない）解に絞り込んだ ZDD を出力する
+		int m = static_cast<int>(graph.GetEdgeList().size());
+		ZDDManager manager(m);
+		ZDDManager::NodeId f = manager.Import(zdd);
+		delete zdd;
+		for (size_t k = 0; k < filters.size(); ++k) {
+			if (filters[k].first > m) {
+				PrintUsage();
+				return 1;
+			}
+			int level = position[filters[k].first - 1] + 1;
+			f = (filters[k].second == 1 ? manager.OnSet(f, level) : manager.OffSet(f, level));
+		}
+		cerr << "# of nodes of ZDD = " << manager.GetNumberOfNodes(f);
+		cerr << ", # of solutions = " << manager.Count(f) << endl;
+		if (export_zdd) {
+			manager.Export(f, &cout, export_format);
+			if (memory_profile) {
+				PrintMemoryProfile(&profile);
+			}
+			return 0;
+		}
+		string text = manager.ToString(f);
+		if (memory_profile) {
+			profile.Set(kMemoryOutput, static_cast<int64_t>(text.capacity()));
+			PrintMemoryProfile(&profile);
+		}
+		cout << text;
+		return 0;
+	}
+
+	if (!weights_file.empty()) { // 重みベクトルごとに解の重みの和の最小値（最大値）を出力する
+		vector<vector<double> > weights;
+		if (!ReadWeights(weights_file, graph.GetEdgeList().size(), &weights)) {
+			cerr << "cannot read weights from " << weights_file << endl;
+			delete zdd;
+			return 1;
+		}
+		for (size_t k = 0; k < weights.size(); ++k) { // 並べ替えた辺の順にする
+			vector<double> w(weights[k].size());
+			for (size_t e = 0; e < w.size(); ++e) {
+				w[position[e]] = weights[k][e];
+			}
+			weights[k].swap(w);
+		}
+		vector<double> results;
+		zdd->EvaluateWeights(weights, maximize, &results, num_threads);
+		cerr << "# of nodes of ZDD = " << zdd->GetNumberOfNodes();
+		cerr << ", # of weight vectors = " << weights.size() << endl;
+		cout.precision(15);
+		for (size_t k = 0; k < results.size(); ++k) {
+			cout << results[k] << endl;
+		}
+		delete zdd;
+		return 0;
+	}
 
 	// 作成されたZDDのノード数と解の数を出力
 	cerr << "# of nodes of ZDD = " << zdd->GetNumberOfNodes();
-	cerr << ", # of solutions = " << zdd->GetNumberOfSolutions() << endl;
+	cerr << ", # of solutions = " << zdd->GetNumberOfSolutions(num_threads) << endl;
 
 	// ZDDを標準出力に出力
-	cout << zdd->GetZDDString();
+	if (export_zdd) { // 既約にしながら書き出す（文字列は作らない）
+		if (memory_profile) {
+			PrintMemoryProfile(&profile);
+		}
+		zdd->Export(&cout, export_format);
+		delete zdd;
+		return 0;
+	}
+	string text = zdd->GetZDDString();
+	if (memory_profile) {
+		profile.Set(kMemoryOutput, static_cast<int64_t>(text.capacity()));
+		PrintMemoryProfile(&profile);
+	}
+	cout << text;
 
 	// 後処理
 	delete zdd;
@@ -0,0 +1,4359 @@
+//
+// frontier.cpp
+//
+// Copyright (c) 2014 Jun Kawahara
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "frontier.h"
+
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
+#include <cmath>
+#include <climits>
+#include <random>
+#include <map>
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <dirent.h>
+#include <unistd.h>
+
+// x86-64 の GCC, Clang では SSE2, AVX2 のカーネルを用いる（AVX2 は実行時に判定する）
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FRONTIER_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define FRONTIER_X86_SIMD 0
+#endif
+
+// アルゴリズム本体は FrontierAlgorithm クラスの Construct 関数である。
+
+using namespace std;
+
+namespace frontier {
+
+//******************************************************************************
+// 補助関数
+
+// 配列 vec に，element が含まれるかどうかを判定。
+// 含まれるなら true を，含まれないなら false を返す。
+static bool Contains(const vector<int>& vec, int element)
+{
+	return std::find(vec.begin(), vec.end(), element) != vec.end();
+}
+
+// 配列 vec の中から element を全て削除する。
+static void Remove(vector<int>* vec, int element)
+{
+	vec->erase(std::remove(vec->begin(), vec->end(), element), vec->end());
+}
+
+// 64 ビット値の混合（ハッシュ値の計算用）
+static inline uint64_t MixHash(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+// p 以上で最小の，64 バイト境界にそろった位置を返す。
+// p の指す配列は，8 要素分余分に確保しておくこと。
+template <typename T>
+static T* AlignToCacheLine(T* p)
+{
+	uintptr_t address = reinterpret_cast<uintptr_t>(p);
+	return reinterpret_cast<T*>((address + 63) & ~static_cast<uintptr_t>(63));
+}
+
+//******************************************************************************
+// Graph 構造体
+
+Graph::Graph()
+{
+	number_of_vertices_ = 0;
+	directed_ = false;
+}
+
+// テキストを1行ずつ読み，行内の非負整数を順に取り出す（istream より十分速い）
+class TextScanner {
+private:
+	const char* p_;
+	const char* end_;
+
+public:
+	TextScanner(const char* begin, const char* end)
+	{
+		p_ = begin;
+		end_ = end;
+	}
+
+	// 行の先頭にいるとき，テキストが終わっていれば true を返す
+	bool IsEnd()
+	{
+		return p_ >= end_;
+	}
+
+	// 行の最初の空白でない文字（行末なら '\n'）を返す
+	char PeekLineHead()
+	{
+		const char* q = p_;
+		while (q < end_ && (*q == ' ' || *q == '\t' || *q == '\r')) {
+			++q;
+		}
+		return (q < end_ ? *q : '\n');
+	}
+
+	// 行内の次の非負整数を value に格納する。数でない語（"-2" のような負の数も含む），
+	// int に収まらない数に当たるか行末なら false を返す（行の残りは NextLine で飛ばす）
+	bool NextInt(int* value)
+	{
+		while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) {
+			++p_;
+		}
+		if (p_ >= end_ || *p_ < '0' || *p_ > '9') {
+			return false;
+		}
+		int x = 0;
+		while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+			int d = *p_ - '0';
+			if (x > (INT_MAX - d) / 10) { // 桁あふれ
+				return false;
+			}
+			x = x * 10 + d;
+			++p_;
+		}
+		*value = x;
+		return true;
+	}
+
+	// 行内の次の語を飛ばす（DIMACS の "p sp" の "sp" など）
+	void SkipWord()
+	{
+		while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) {
+			++p_;
+		}
+		while (p_ < end_ && *p_ != ' ' && *p_ != '\t' && *p_ != '\r' && *p_ != '\n') {
+			++p_;
+		}
+	}
+
+	// 次の行の先頭に進む
+	void NextLine()
+	{
+		const char* q = static_cast<const char*>(std::memchr(p_, '\n', end_ - p_));
+		p_ = (q != NULL ? q + 1 : end_);
+	}
+};
+
+// ファイルから隣接リスト形式のグラフを読み込む
+void Graph::ParseAdjListText(istream& ist)
+{
+	string text((std::istreambuf_iterator<char>(ist)), std::istreambuf_iterator<char>());
+	ParseText(text.data(), text.data() + text.size(), kGraphFormatAdjList);
+}
+
+void Graph::ParseText(const char* begin, const char* end, GraphFormat format)
+{
+	number_of_vertices_ = 0;
+	edge_list_.clear();
+
+	vector<Edge> edges; // 自己ループを除いた辺（無向なら src < dest，重複を含む）
+	int max_vertex = 0;
+	bool zero_based = false; // 辺リストで頂点番号 0 が現れたか
+	TextScanner scanner(begin, end);
+	for (; !scanner.IsEnd(); scanner.NextLine()) {
+		int u, v;
+		if (format == kGraphFormatEdgeList) {
+			char head = scanner.PeekLineHead();
+			if (head == '#' || head == '%' || !scanner.NextInt(&u) || !scanner.NextInt(&v)) {
+				continue;
+			}
+			zero_based = zero_based || u == 0 || v == 0;
+		} else if (format == kGraphFormatDimacs) {
+			char head = scanner.PeekLineHead();
+			scanner.SkipWord();
+			if (head == 'p') { // "p sp n m" など
+				scanner.SkipWord();
+				if (scanner.NextInt(&u) && number_of_vertices_ < u) {
+					number_of_vertices_ = u;
+				}
+				continue;
+			}
+			if ((head != 'a' && head != 'e') || !scanner.NextInt(&u) || !scanner.NextInt(&v)) {
+				continue;
+			}
+		} else { // 隣接リスト。i 行目は頂点 i（空行も数える）
+			++number_of_vertices_;
+			u = number_of_vertices_;
+			while (scanner.NextInt(&v)) {
+				if (u != v) { // src == dest のものは無視
+					edges.push_back(directed_ ? Edge(u, v) : Edge(std::min(u, v), std::max(u, v)));
+				}
+				max_vertex = std::max(max_vertex, v);
+			}
+			continue;
+		}
+		if (u != v) {
+			edges.push_back(directed_ ? Edge(u, v) : Edge(std::min(u, v), std::max(u, v)));
+		}
+		max_vertex = std::max(max_vertex, std::max(u, v));
+	}
+	if (zero_based) {
+		for (size_t e = 0; e < edges.size(); ++e) {
+			++edges[e].src;
+			++edges[e].dest;
+		}
+		++max_vertex;
+	}
+	if (number_of_vertices_ < max_vertex) {
+		number_of_vertices_ = max_vertex;
+	}
+
+	// 重複除去。(src, dest, 位置) で整列して，同じ辺のうち最初のものだけに印を付ける
+	vector<std::pair<uint64_t, size_t> > keys(edges.size());
+	for (size_t e = 0; e < edges.size(); ++e) {
+		keys[e] = std::make_pair(static_cast<uint64_t>(edges[e].src) << 32
+			| static_cast<uint32_t>(edges[e].dest), e);
+	}
+	std::sort(keys.begin(), keys.end());
+	vector<char> is_first(edges.size(), 0);
+	for (size_t k = 0; k < keys.size(); ++k) {
+		if (k == 0 || keys[k].first != keys[k - 1].first) {
+			is_first[keys[k].second] = 1;
+		}
+	}
+	for (size_t e = 0; e < edges.size(); ++e) {
+		if (is_first[e]) {
+			edge_list_.push_back(edges[e]); // 辺を追加
+		}
+	}
+	if (directed_) {
+		// 逆向きの弧どうしを隣に並べる（両端の組が最初に現れた順）。無向グラフとして
+		// 読んだときと辺の順序がそろうので，フロンティアの大きさも同じになる
+		vector<std::pair<std::pair<size_t, int>, size_t> > order(edge_list_.size());
+		std::map<std::pair<int, int>, size_t> first;
+		for (size_t e = 0; e < edge_list_.size(); ++e) {
+			const Edge& edge = edge_list_[e];
+			std::pair<int, int> ends(std::min(edge.src, edge.dest), std::max(edge.src, edge.dest));
+			size_t position = first.insert(std::make_pair(ends, e)).first->second;
+			order[e] = std::make_pair(std::make_pair(position, edge.src == ends.first ? 0 : 1), e);
+		}
+		std::sort(order.begin(), order.end());
+		vector<Edge> arcs;
+		for (size_t k = 0; k < order.size(); ++k) {
+			arcs.push_back(edge_list_[order[k].second]);
+		}
+		edge_list_.swap(arcs);
+	}
+}
+
+bool Graph::LoadFile(const string& path, GraphFormat format)
+{
+	if (format == kGraphFormatAuto) {
+		format = DetectFormat(path);
+	}
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return false;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		ParseText(NULL, NULL, format);
+		return true;
+	}
+	void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		return false;
+	}
+	madvise(p, st.st_size, MADV_SEQUENTIAL);
+	const char* text = static_cast<const char*>(p);
+	ParseText(text, text + st.st_size, format);
+	munmap(p, st.st_size);
+	return true;
+}
+
+GraphFormat Graph::DetectFormat(const string& path)
+{
+	size_t dot = path.find_last_of('.');
+	string extension = (dot == string::npos || path.find('/', dot) != string::npos
+		? string() : path.substr(dot + 1));
+	if (extension == "gr" || extension == "dimacs" || extension == "col") {
+		return kGraphFormatDimacs;
+	} else if (extension == "el" || extension == "edge" || extension == "edges"
+		|| extension == "edgelist") {
+		return kGraphFormatEdgeList;
+	}
+	return kGraphFormatAdjList;
+}
+
+// rows x cols の格子グラフを作成する。頂点番号は左上から行優先で 1, 2, ... と振る。
+// 辺は各頂点について右，下の順に並べる（フロンティアの大きさは cols + 1 以下）。
+void Graph::MakeGrid(int rows, int cols)
+{
+	number_of_vertices_ = rows * cols;
+	edge_list_.clear();
+
+	for (int r = 0; r < rows; ++r) {
+		for (int c = 0; c < cols; ++c) {
+			int v = r * cols + c + 1;
+			if (c + 1 < cols) {
+				edge_list_.push_back(Edge(v, v + 1));
+			}
+			if (r + 1 < rows) {
+				edge_list_.push_back(Edge(v, v + cols));
+			}
+		}
+	}
+}
+
+// 頂点の数と辺リストからグラフを作成する
+void Graph::SetEdgeList(int number_of_vertices, const vector<Edge>& edge_list)
+{
+	number_of_vertices_ = number_of_vertices;
+	edge_list_ = edge_list;
+}
+
+string Graph::ToString()
+{
+	ostringstream oss;
+	for (size_t i = 0; i < edge_list_.size(); ++i)
+	{
+		oss << "(" << edge_list_[i].src << ", " << edge_list_[i].dest
+			<< ")";
+		if (i < edge_list_.size() - 1)
+		{
+			oss << ", ";
+		}
+	}
+	return oss.str();
+}
+
+//******************************************************************************
+// ZDDNode 構造体
+
+ZDDNode::ZDDNode()
+{
+	deg = NULL;
+	comp = NULL;
+	zero_child = NULL;
+	one_child = NULL;
+	id_ = -1;
+}
+
+ZDDNode::~ZDDNode()
+{
+	delete[] deg;
+	delete[] comp;
+}
+
+// 根(root)ノードを作成して返す。ID は ZDD::AddNode で振られる。
+// number_of_vertices: 入力グラフの頂点の数
+ZDDNode* ZDDNode::CreateRootNode(int number_of_vertices)
+{
+	ZDDNode* node = new ZDDNode();
+	node->deg = new int[number_of_vertices + 1];
+	node->comp = new int[number_of_vertices + 1];
+
+	// deg, comp を初期化
+	for (int i = 1; i <= number_of_vertices; ++i)
+	{
+		node->deg[i] = 0;
+		node->comp[i] = i;
+	}
+	return node;
+}
+
+// ZDDノードをコピーして返す。
+// number_of_vertices: 入力グラフの頂点の数
+ZDDNode* ZDDNode::MakeCopy(int number_of_vertices)
+{
+	ZDDNode* node = new ZDDNode();
+	node->deg = new int[number_of_vertices + 1];
+	node->comp = new int[number_of_vertices + 1];
+
+	// deg, comp 配列をコピー
+	for (int i = 1; i <= number_of_vertices; ++i)
+	{
+		node->deg[i] = deg[i];
+		node->comp[i] = comp[i];
+	}
+	return node;
+}
+
+// ノードに子を設定
+// child_num: 0 なら0枝側の子として node を設定
+// 1 なら1枝側の子として node を設定
+void ZDDNode::SetChild(ZDDNode* node, int child_num)
+{
+	if (child_num == 0)
+	{
+		zero_child = node;
+	}
+	else
+	{
+		one_child = node;
+	}
+}
+
+// ノードの子ノードを取得
+// child_num: 0 なら0枝側の子を取得
+// 1 なら1枝側の子を取得
+ZDDNode* ZDDNode::GetChild(int child_num)
+{
+	if (child_num == 0)
+	{
+		return zero_child;
+	}
+	else
+	{
+		return one_child;
+	}
+}
+
+// ZDDノードを文字列にして返す
+string ZDDNode::ToString()
+{
+	ostringstream oss;
+	oss << id_;
+
+	if (id_ >= 2)
+	{
+		oss << ":" << zero_child->id_ << "," << one_child->id_;
+	}
+	return oss.str();
+}
+
+//******************************************************************************
+// State 構造体
+
+State::State(Graph* g, int start, int end)
+{
+	s = start;
+	t = end;
+	terminal_pairs.push_back(std::make_pair(start, end));
+	graph = g;
+	ComputeFrontier();
+}
+
+State::State(Graph* g, const vector<std::pair<int, int> >& pairs)
+{
+	s = pairs[0].first;
+	t = pairs[0].second;
+	terminal_pairs = pairs;
+	graph = g;
+	ComputeFrontier();
+}
+
+State::~State()
+{
+	for (size_t i = 0; i < graph->GetEdgeList().size() + 1; ++i) {
+		delete F[i];
+	}
+	delete[] F;
+}
+
+void State::ComputeFrontier() // フロンティアの計算
+{
+	const vector<Edge>& edge_list = graph->GetEdgeList();
+
+	F = new vector<int>*[edge_list.size() + 1];
+	F[0] = new vector<int>;
+
+	for (size_t i = 0; i < edge_list.size(); ++i)
+	{
+		F[i + 1] = new vector<int>;
+		// i 番目のフロンティア配列の要素すべてを，i + 1 番目のフロンティア配列に追加する
+		for (size_t j = 0; j < F[i]->size(); ++j) {
+			F[i + 1]->push_back((*F[i])[j]);
+		}
+
+		Edge edge = edge_list[i];
+		int src = edge.src;
+		int dest = edge.dest;
+
+		// i + 1 番目のフロンティア配列に src が含まれない（重複チェック）
+		if (!Contains(*F[i + 1], src))
+		{
+			// i + 1 番目のフロンティア配列に src を追加
+			F[i + 1]->push_back(src);
+		}
+		// dest に対しても同様の処理
+		if (!Contains(*F[i + 1], dest))
+		{
+			F[i + 1]->push_back(dest);
+		}
+
+		// i + 1 番目以降の辺に，頂点 src が出現しないかどうかチェック。
+		// 出現しないなら，i + 1 番目のフロンティアから src が去るので，
+		// src を削除する。
+		if (!FindElement(i, src))
+		{
+			// src を削除
+			Remove(F[i + 1], src);
+		}
+		// dest に対しても同様の処理
+		if (!FindElement(i, dest))
+		{
+			Remove(F[i + 1], dest);
+		}
+	}
+}
+
+// i + 1 番目以降の辺に，頂点 src が出現しないかどうかチェック。
+// 出現するなら true を，しないなら false を返す。
+bool State::FindElement(int edge_number, int value)
+{
+	const vector<Edge>& edge_list = graph->GetEdgeList();
+	for (size_t i = edge_number + 1; i < edge_list.size(); ++i)
+	{
+		if (value == edge_list[i].src || value == edge_list[i].dest)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//******************************************************************************
+// ZDD 構造体
+
+ZDD::ZDD(int number_of_levels) : node_list_array_(number_of_levels)
+{
+	zero_terminal_.id_ = 0;
+	one_terminal_.id_ = 1;
+	total_id_ = 2;
+}
+
+ZDD::~ZDD()
+{
+	for (size_t i = 0; i < node_list_array_.size(); ++i) {
+		for (size_t j = 0; j < node_list_array_[i].size(); ++j) {
+			delete node_list_array_[i][j];
+		}
+	}
+}
+
+// node に次のIDを振って，レベル level に追加する
+void ZDD::AddNode(int level, ZDDNode* node)
+{
+	child_ids_.clear();
+	node->id_ = total_id_;
+	++total_id_;
+	node_list_array_[level].push_back(node);
+}
+
+// ZDDのノード数を返す
+int64_t ZDD::GetNumberOfNodes()
+{
+	int64_t num = 0;
+	for (size_t i = 1; i < node_list_array_.size(); ++i)
+	{
+		num += static_cast<int64_t>(node_list_array_[i].size());
+	}
+	return num + 2; // + 2 は終端ノードの分
+}
+
+// ZDDが表現する集合族の大きさ（解の個数）を返す
+int64_t ZDD::GetNumberOfSolutions(int num_threads)
+{
+	if (node_list_array_.size() <= 2) { // 辺がない（根の子がないが，s != t なので解はない）
+		return 0;
+	}
+	// sol[id] は ID が id のノードの解の個数。先頭を 64 バイト境界にそろえる
+	vector<int64_t> storage(total_id_ + 8);
+	int64_t* sol = AlignToCacheLine(storage.data());
+	sol[0] = 0; // 0終端
+	sol[1] = 1; // 1終端
+
+	// 動的計画法による解の個数の計算。
+	// 0枝側のノードの解の個数と，1枝側のノードの解の個数を足したものが，
+	// そのノードの解の個数になる。
+	// レベルが高いノードから低いノードに向けて計算する
+	if (!child_ids_.empty()) { // 子の ID の表を順に読む（レベル i のノードの ID は連続している）
+		const int* child = child_ids_.data();
+		ForEachLevelBottomUp(num_threads, [this, sol, child](int i, size_t begin, size_t end) {
+			int first = node_list_array_[i][0]->id_;
+			for (int id = first + static_cast<int>(begin); id < first + static_cast<int>(end); ++id) {
+				sol[id] = sol[child[2 * id]] + sol[child[2 * id + 1]];
+			}
+		});
+		return sol[node_list_array_[1][0]->id_];
+	}
+	ForEachLevelBottomUp(num_threads, [this, sol](int i, size_t begin, size_t end) {
+		const vector<ZDDNode*>& N_i = node_list_array_[i];
+		for (size_t j = begin; j < end; ++j)
+		{
+			ZDDNode* node = N_i[j];
+			sol[node->id_] = sol[node->zero_child->id_] + sol[node->one_child->id_];
+		}
+	});
+	return sol[node_list_array_[1][0]->id_];
+}
+
+// 重みの行 1 本分（ZDD::kWeightRowWidth 個）について，
+// out[r] = min(lo[r], hi[r] + w[r])（maximize なら max）を求める
+static void EvaluateWeightRow(double* out, const double* lo, const double* hi,
+	const double* w, bool maximize)
+{
+	const int R = ZDD::kWeightRowWidth;
+#if FRONTIER_X86_SIMD
+	// x86-64 では SSE2 は常に使える。行はキャッシュライン境界にそろえてある
+	for (int r = 0; r < R; r += 2) {
+		__m128d x = _mm_add_pd(_mm_load_pd(hi + r), _mm_loadu_pd(w + r));
+		__m128d y = _mm_load_pd(lo + r);
+		_mm_store_pd(out + r, maximize ? _mm_max_pd(y, x) : _mm_min_pd(y, x));
+	}
+#else
+	for (int r = 0; r < R; ++r) {
+		double x = hi[r] + w[r];
+		out[r] = (maximize ? (lo[r] > x ? lo[r] : x) : (lo[r] < x ? lo[r] : x));
+	}
+#endif
+}
+
+void ZDD::EvaluateWeights(const vector<vector<double> >& weights, bool maximize,
+	vector<double>* results, int num_threads)
+{
+	const int R = kWeightRowWidth;
+	int m = static_cast<int>(node_list_array_.size()) - 2; // 辺の数
+	const double none = (maximize ? -HUGE_VAL : HUGE_VAL); // 解がないときの値
+	results->assign(weights.size(), none);
+	if (node_list_array_.size() <= 2) { // 辺がない（GetNumberOfSolutions と同じく解はない）
+		return;
+	}
+
+	// value[id * R + r] は ID が id のノードの，行の r 番目の重みベクトルでの値。
+	// 行の先頭を 64 バイト境界にそろえる
+	vector<double> storage(static_cast<size_t>(total_id_) * R + 8);
+	double* value = AlignToCacheLine(storage.data());
+	// w[(i - 1) * R + r] はレベル i の辺の，行の r 番目の重みベクトルでの重み
+	vector<double> w(static_cast<size_t>(m) * R);
+
+	for (size_t base = 0; base < weights.size(); base += R) {
+		size_t count = std::min(weights.size() - base, static_cast<size_t>(R));
+		for (int i = 1; i <= m; ++i) {
+			for (size_t r = 0; r < static_cast<size_t>(R); ++r) {
+				w[(i - 1) * R + r] = (r < count ? weights[base + r][i - 1] : 0.0);
+			}
+		}
+		for (int r = 0; r < R; ++r) {
+			value[r] = none;  // 0終端
+			value[R + r] = 0; // 1終端
+		}
+
+		// GetNumberOfSolutions と同じく，子ノードの行から親ノードの行を求める。
+		// 0枝側の値と，1枝側の値にその辺の重みを足したものの小さい（大きい）方が
+		// そのノードの値になる
+		// 子の ID の表があればそれを順に読む（Renumber を参照）
+		const int* child = (child_ids_.empty() ? NULL : child_ids_.data());
+		ForEachLevelBottomUp(num_threads, [this, value, &w, maximize, child](int i,
+			size_t begin, size_t end) {
+			const vector<ZDDNode*>& N_i = node_list_array_[i];
+			const double* w_i = &w[(i - 1) * R];
+			if (child != NULL) {
+				size_t first = static_cast<size_t>(N_i[0]->id_);
+				for (size_t id = first + begin; id < first + end; ++id) {
+					EvaluateWeightRow(value + id * R, value + static_cast<size_t>(child[2 * id]) * R,
+						value + static_cast<size_t>(child[2 * id + 1]) * R, w_i, maximize);
+				}
+				return;
+			}
+			for (size_t j = begin; j < end; ++j)
+			{
+				ZDDNode* node = N_i[j];
+				EvaluateWeightRow(value + static_cast<size_t>(node->id_) * R,
+					value + static_cast<size_t>(node->zero_child->id_) * R,
+					value + static_cast<size_t>(node->one_child->id_) * R, w_i, maximize);
+			}
+		});
+
+		const double* root = value + static_cast<size_t>(node_list_array_[1][0]->id_) * R;
+		for (size_t r = 0; r < count; ++r) {
+			(*results)[base + r] = root[r];
+		}
+	}
+}
+
+// スレッドが全員そろうまで待つための障壁
+class LevelBarrier {
+private:
+	mutex mutex_;
+	condition_variable cond_;
+	int num_threads_;
+	int count_;      // 到着していないスレッドの数
+	int generation_; // 何回目の待ち合わせか
+
+public:
+	LevelBarrier(int num_threads)
+	{
+		num_threads_ = num_threads;
+		count_ = num_threads;
+		generation_ = 0;
+	}
+
+	void Wait()
+	{
+		unique_lock<mutex> lock(mutex_);
+		int generation = generation_;
+		if (--count_ == 0) {
+			++generation_;
+			count_ = num_threads_;
+			cond_.notify_all();
+		} else {
+			cond_.wait(lock, [this, generation] { return generation != generation_; });
+		}
+	}
+};
+
+// これより少ないノードしかないレベルは1つのスレッドで処理する
+static const size_t kMinParallelLevelSize = 4096;
+
+void ZDD::ForEachLevelBottomUp(int num_threads,
+	const function<void(int level, size_t begin, size_t end)>& func)
+{
+	int top = static_cast<int>(node_list_array_.size()) - 1;
+
+	if (num_threads <= 1) {
+		for (int i = top; i >= 1; --i) {
+			if (!node_list_array_[i].empty()) {
+				func(i, 0, node_list_array_[i].size());
+			}
+		}
+		return;
+	}
+
+	LevelBarrier barrier(num_threads);
+	// t 番目のスレッドの処理。レベル i の分担を計算して func を呼び，全員を待つ
+	auto worker = [&](int t) {
+		for (int i = top; i >= 1; --i) {
+			const vector<ZDDNode*>& N_i = node_list_array_[i];
+			size_t size = N_i.size();
+			size_t begin = 0, end = 0;
+			if (size < kMinParallelLevelSize) {
+				end = (t == 0 ? size : 0);
+			} else {
+				// 分担の大きさを 8 の倍数にし，境界をノードIDが 8 の倍数の位置にそろえる
+				size_t chunk = ((size + num_threads - 1) / num_threads + 7) / 8 * 8;
+				size_t offset = (8 - static_cast<size_t>(N_i[0]->id_) % 8) % 8;
+				begin = (t == 0 ? 0 : std::min(size, offset + t * chunk));
+				end = (t == num_threads - 1 ? size : std::min(size, offset + (t + 1) * chunk));
+			}
+			if (begin < end) {
+				func(i, begin, end);
+			}
+			barrier.Wait();
+		}
+	};
+
+	vector<thread> threads;
+	for (int t = 1; t < num_threads; ++t) {
+		threads.push_back(thread(worker, t));
+	}
+	worker(0);
+	for (size_t t = 0; t < threads.size(); ++t) {
+		threads[t].join();
+	}
+}
+
+void ZDD::DeleteEdges(const vector<int>& levels)
+{
+	bool renumbered = !child_ids_.empty(); // 子の ID の表は最後に作り直す
+	child_ids_.clear();
+	int m = static_cast<int>(node_list_array_.size()) - 2; // 辺の数
+	vector<bool> deleted(m + 1, false);
+	int last = 0; // 削除する辺の最大のレベル。それより下のレベルのノードは変わらない
+	for (size_t k = 0; k < levels.size(); ++k) {
+		if (1 <= levels[k] && levels[k] <= m) {
+			deleted[levels[k]] = true;
+			last = std::max(last, levels[k]);
+		}
+	}
+	if (last == 0) {
+		if (renumbered) {
+			Renumber();
+		}
+		return;
+	}
+
+	// forward[id] はまとめたノード（ID が id）の代わりのノード（まとめていなければ NULL）。
+	// 親のレベルで子の ID を引くので，まとめたノードは released に入れて最後に解放する
+	vector<ZDDNode*> forward(total_id_, NULL);
+	vector<ZDDNode*> released;
+	vector<ZDDNode*> table; // 子の ID の組で引く開番地法のハッシュ表（NULL なら空き）
+	for (int i = last; i >= 1; --i) {
+		vector<ZDDNode*>& N_i = node_list_array_[i];
+		size_t capacity = 2;
+		while (capacity < N_i.size() * 2) { // 負荷率を 1/2 以下にする
+			capacity *= 2;
+		}
+		table.assign(capacity, NULL);
+		size_t mask = capacity - 1;
+		for (size_t j = 0; j < N_i.size(); ++j) {
+			ZDDNode* node = N_i[j];
+			for (int x = 0; x <= 1; ++x) {
+				ZDDNode* child = node->GetChild(x);
+				if (forward[child->id_] != NULL) {
+					node->SetChild(forward[child->id_], x);
+				}
+			}
+			if (deleted[i]) {
+				node->SetChild(&zero_terminal_, 1);
+			}
+			ZDDNode* lo = node->zero_child;
+			ZDDNode* hi = node->one_child;
+			if (i > 1 && lo->id_ == 0 && hi->id_ == 0) { // 解のないノード
+				forward[node->id_] = &zero_terminal_;
+				continue;
+			}
+			// 子の等しいノードは，レベルの中で最も前のものにまとめる
+			size_t h = MixHash(static_cast<uint64_t>(lo->id_) << 32 | static_cast<uint32_t>(hi->id_))
+				& mask;
+			while (table[h] != NULL && (table[h]->zero_child != lo || table[h]->one_child != hi)) {
+				h = (h + 1) & mask;
+			}
+			if (table[h] != NULL) {
+				forward[node->id_] = table[h];
+			} else {
+				table[h] = node;
+			}
+		}
+		size_t kept = 0;
+		for (size_t j = 0; j < N_i.size(); ++j) {
+			if (forward[N_i[j]->id_] != NULL) {
+				released.push_back(N_i[j]);
+			} else {
+				N_i[kept++] = N_i[j];
+			}
+		}
+		N_i.resize(kept);
+	}
+	for (size_t k = 0; k < released.size(); ++k) {
+		delete released[k];
+	}
+
+	// 根から到達できないノードを上のレベルから順に解放し，残ったノードに ID を振り直す。
+	// reachable は振り直す前の ID で引く（子のレベルは親より後に振り直すので，
+	// 子の ID はまだ振り直す前のもの）
+	vector<bool> reachable(total_id_, false);
+	reachable[node_list_array_[1][0]->id_] = true;
+	total_id_ = 2;
+	for (size_t i = 1; i < node_list_array_.size(); ++i) {
+		vector<ZDDNode*>& N_i = node_list_array_[i];
+		size_t kept = 0;
+		for (size_t j = 0; j < N_i.size(); ++j) {
+			ZDDNode* node = N_i[j];
+			if (!reachable[node->id_]) {
+				delete node;
+				continue;
+			}
+			reachable[node->zero_child->id_] = true;
+			reachable[node->one_child->id_] = true;
+			node->id_ = total_id_;
+			++total_id_;
+			N_i[kept++] = node;
+		}
+		N_i.resize(kept);
+	}
+	if (renumbered) {
+		Renumber();
+	}
+}
+
+void ZDD::Renumber()
+{
+	child_ids_.clear();
+	if (node_list_array_.size() <= 2) { // 辺がない（根の子がない）
+		return;
+	}
+	// レベル i のノード（並べ替えた後の順）を順に見て，子に初めて参照された順に次のレベルの
+	// ID を振り，子の ID の表を埋める。new_id は振り直す前の ID で引く。子のノードの ID は
+	// そのレベルを見るときに書き換えるので，親を見ている間は振り直す前のまま
+	vector<int> new_id(total_id_, -1);
+	new_id[0] = 0;
+	new_id[1] = 1;
+	new_id[node_list_array_[1][0]->id_] = 2;
+	child_ids_.assign(static_cast<size_t>(total_id_) * 2, 0);
+	int first = 2; // レベル i の最初のノードの新しい ID
+	vector<ZDDNode*> order;
+	for (size_t i = 1; i < node_list_array_.size(); ++i) {
+		vector<ZDDNode*>& N_i = node_list_array_[i];
+		int next_first = first + static_cast<int>(N_i.size());
+		int next_id = next_first;
+		order.clear();
+		for (size_t j = 0; j < N_i.size(); ++j) {
+			ZDDNode* node = N_i[j];
+			int id = first + static_cast<int>(j);
+			if (i + 1 < node_list_array_.size()) {
+				for (int x = 0; x <= 1; ++x) {
+					ZDDNode* child = node->GetChild(x);
+					int& child_id = new_id[child->id_];
+					if (child_id < 0) {
+						child_id = next_id;
+						++next_id;
+						order.push_back(child);
+					}
+					child_ids_[2 * id + x] = child_id;
+				}
+			}
+			node->id_ = id;
+		}
+		if (i + 1 < node_list_array_.size()) {
+			// 参照されないノードは元の順で後ろに置く
+			vector<ZDDNode*>& next = node_list_array_[i + 1];
+			for (size_t j = 0; j < next.size() && order.size() < next.size(); ++j) {
+				if (new_id[next[j]->id_] < 0) {
+					new_id[next[j]->id_] = next_id;
+					++next_id;
+					order.push_back(next[j]);
+				}
+			}
+			next.swap(order);
+		}
+		first = next_first;
+	}
+	total_id_ = first;
+	child_ids_.resize(static_cast<size_t>(total_id_) * 2);
+}
+
+// ZDDを文字列にして返す
+string ZDD::GetZDDString()
+{
+	ostringstream oss;
+
+	for (size_t i = 1; i < node_list_array_.size() - 1; ++i) {
+		oss << "#" << i << "\r\n";
+		for (size_t j = 0; j < node_list_array_[i].size(); ++j) {
+			oss << node_list_array_[i][j]->ToString() << "\r\n";
+		}
+	}
+	return oss.str();
+}
+
+void ZDD::Export(ostream* out, ZDDFormat format)
+{
+	int m = static_cast<int>(node_list_array_.size()) - 2; // 辺の数
+	// canonical[id] は ID が id のノードを書き出すときの番号（0終端は 0，1終端は 1）。
+	// 子の番号が決まってから親を見るので，レベルの大きい方から決める
+	vector<int> canonical(total_id_, 0);
+	canonical[1] = 1;
+	struct Entry {
+		int lo, hi, id; // 子の番号と自身の番号（id が 0 なら空き）
+	};
+	vector<Entry> table; // 子の番号の組で引く開番地法のハッシュ表
+	int next = 2;
+	for (int i = m; i >= 1; --i) {
+		const vector<ZDDNode*>& N_i = node_list_array_[i];
+		size_t capacity = 2;
+		while (capacity < N_i.size() * 2) { // 負荷率を 1/2 以下にする
+			capacity *= 2;
+		}
+		Entry empty = { 0, 0, 0 };
+		table.assign(capacity, empty);
+		size_t mask = capacity - 1;
+		for (size_t j = 0; j < N_i.size(); ++j) {
+			int lo = canonical[N_i[j]->zero_child->id_];
+			int hi = canonical[N_i[j]->one_child->id_];
+			if (hi == 0) {
+				canonical[N_i[j]->id_] = lo;
+				continue;
+			}
+			size_t h = MixHash(static_cast<uint64_t>(lo) << 32 | static_cast<uint32_t>(hi)) & mask;
+			while (table[h].id != 0 && (table[h].lo != lo || table[h].hi != hi)) {
+				h = (h + 1) & mask;
+			}
+			if (table[h].id == 0) {
+				table[h].lo = lo;
+				table[h].hi = hi;
+				table[h].id = next++;
+			}
+			canonical[N_i[j]->id_] = table[h].id;
+		}
+	}
+	vector<Entry>().swap(table);
+
+	// 番号を決めたときと同じ順に見て，新しい番号を与えたノードだけを書く
+	// （ZDDExporter も 2 から順に番号を返す）
+	ZDDExporter exporter(out, format, m, next - 2);
+	int expected = 2;
+	for (int i = m; i >= 1; --i) {
+		const vector<ZDDNode*>& N_i = node_list_array_[i];
+		for (size_t j = 0; j < N_i.size(); ++j) {
+			if (canonical[N_i[j]->id_] == expected) {
+				exporter.AddNode(i, canonical[N_i[j]->zero_child->id_],
+					canonical[N_i[j]->one_child->id_]);
+				++expected;
+			}
+		}
+	}
+	exporter.Finish(m >= 1 && !node_list_array_[1].empty() ? canonical[node_list_array_[1][0]->id_] : 0);
+}
+
+//******************************************************************************
+// ZDDExporter
+
+bool ParseZDDFormat(const string& name, ZDDFormat* format)
+{
+	if (name == "sapporo") {
+		*format = kFormatSapporo;
+	} else if (name == "graphillion") {
+		*format = kFormatGraphillion;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+ZDDExporter::ZDDExporter(ostream* out, ZDDFormat format, int number_of_variables,
+	int64_t number_of_nodes) : out_(out), format_(format),
+	number_of_variables_(number_of_variables), next_id_(2)
+{
+	if (format_ == kFormatSapporo) {
+		buffer_ += "_i ";
+		AppendInteger(number_of_variables_);
+		buffer_ += "\n_o 1\n_n ";
+		AppendInteger(number_of_nodes);
+		buffer_ += '\n';
+	}
+}
+
+int64_t ZDDExporter::AddNode(int level, int64_t lo, int64_t hi)
+{
+	int64_t id = next_id_++;
+	AppendNode(id);
+	buffer_ += ' ';
+	AppendInteger(format_ == kFormatSapporo ? number_of_variables_ - level + 1 : level);
+	buffer_ += ' ';
+	AppendNode(lo);
+	buffer_ += ' ';
+	AppendNode(hi);
+	buffer_ += '\n';
+	if (buffer_.size() >= (1 << 20)) { // 1 MiB ためたら書く
+		Flush();
+	}
+	return id;
+}
+
+void ZDDExporter::Finish(int64_t root)
+{
+	if (format_ == kFormatSapporo) {
+		AppendNode(root);
+		buffer_ += '\n';
+	} else {
+		if (root < 2) { // 根が最後の行のノードでないときだけ書く
+			AppendNode(root);
+			buffer_ += '\n';
+		}
+		buffer_ += ".\n";
+	}
+	Flush();
+	out_->flush();
+}
+
+void ZDDExporter::AppendInteger(int64_t value)
+{
+	char digits[24];
+	int n = 0;
+	if (value < 0) {
+		buffer_ += '-';
+		value = -value;
+	}
+	do {
+		digits[n++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	while (n > 0) {
+		buffer_ += digits[--n];
+	}
+}
+
+void ZDDExporter::AppendNode(int64_t id)
+{
+	if (id == 0) {
+		buffer_ += (format_ == kFormatSapporo ? 'F' : 'B');
+	} else if (id == 1) {
+		buffer_ += 'T';
+	} else {
+		AppendInteger(format_ == kFormatSapporo ? 2 * id : id);
+	}
+}
+
+void ZDDExporter::Flush()
+{
+	out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+	buffer_.clear();
+}
+
+//******************************************************************************
+// MemoryProfile 構造体
+
+MemoryProfile::MemoryProfile()
+{
+	for (int c = 0; c < kNumberOfMemoryCategories; ++c) {
+		current[c] = 0;
+		peak[c] = 0;
+	}
+	peak_total = 0;
+}
+
+void MemoryProfile::Set(MemoryCategory category, int64_t bytes)
+{
+	current[category] = bytes;
+	peak[category] = std::max(peak[category], bytes);
+	peak_total = std::max(peak_total, GetTotal());
+}
+
+void MemoryProfile::EndLevel(int level)
+{
+	if (static_cast<int>(levels.size()) <= level) {
+		levels.resize(level + 1, vector<int64_t>(kNumberOfMemoryCategories, 0));
+	}
+	levels[level].assign(current, current + kNumberOfMemoryCategories);
+}
+
+int64_t MemoryProfile::GetTotal()
+{
+	int64_t total = 0;
+	for (int c = 0; c < kNumberOfMemoryCategories; ++c) {
+		total += current[c];
+	}
+	return total;
+}
+
+const char* MemoryProfile::GetCategoryName(MemoryCategory category)
+{
+	const char* names[] = { "node", "level", "state", "table", "output" };
+	return names[category];
+}
+
+// レベル 1 から last までのノードの配列の大きさ（バイト）
+static int64_t GetLevelArrayBytes(ZDD* zdd, int last)
+{
+	int64_t bytes = 0;
+	for (int i = 1; i <= last; ++i) {
+		bytes += static_cast<int64_t>(zdd->GetNodeList(i).capacity() * sizeof(ZDDNode*));
+	}
+	return bytes;
+}
+
+// レベル i の構築を終えた時点の使用量を profile に記録する（profile が NULL なら何もしない）。
+// state_bytes, table_bytes はその時点で持っている状態と重複除去の表の大きさ。
+// ノードの配列はレベル i + 1 のものだけが増えるので，*level_bytes（レベル i までの
+// ノードの配列の大きさ。GetLevelArrayBytes で初期化する）に足していく
+static void RecordLevelMemory(MemoryProfile* profile, ZDD* zdd, int i,
+	int64_t state_bytes, int64_t table_bytes, int64_t* level_bytes)
+{
+	if (profile == NULL) {
+		return;
+	}
+	*level_bytes += static_cast<int64_t>(zdd->GetNodeList(i + 1).capacity() * sizeof(ZDDNode*));
+	profile->Set(kMemoryNode, static_cast<int64_t>(zdd->GetNumberOfIds() - 2) * sizeof(ZDDNode));
+	profile->Set(kMemoryLevel, *level_bytes);
+	profile->Set(kMemoryState, state_bytes);
+	profile->Set(kMemoryTable, table_bytes);
+	profile->EndLevel(i);
+}
+
+//******************************************************************************
+// アルゴリズム本体
+
+// フロンティア法を実行し，ZDDを作成して返す
+// アルゴリズムの中身については文献参照
+ZDD* FrontierAlgorithm::Construct(State* state, MemoryProfile* profile)
+{
+	const vector<Edge>& edge_list = state->graph->GetEdgeList();
+	// 生成したノードを格納する ZDD（レベル i のノードの配列が N_i）
+	ZDD* zdd = new ZDD(static_cast<int>(edge_list.size()) + 2);
+	// 根ノードを作成して N_1 に追加
+	zdd->AddNode(1, ZDDNode::CreateRootNode(state->graph->GetNumberOfVertices()));
+	int64_t level_bytes = (profile != NULL ? GetLevelArrayBytes(zdd, 1) : 0); // ノードの配列の大きさ
+
+	for (size_t i = 1; i <= edge_list.size(); ++i) { // 各辺 i についての処理
+		for (size_t j = 0; j < zdd->GetNodeList(i).size(); ++j) { // レベル i の各ノードについての処理
+			ZDDNode* n_hat = zdd->GetNodeList(i)[j]; // レベル i の j 番目のノード
+			for (int x = 0; x <= 1; ++x) { // x枝（x = 0, 1）についての処理
+				ZDDNode* n_prime = CheckTerminal(zdd, n_hat, i, x, state);
+
+				if (n_prime == NULL) { // x枝の先が0終端でも1終端でもないと判定された
+					n_prime = n_hat->MakeCopy(state->graph->GetNumberOfVertices());
+					UpdateInfo(n_prime, i, x, state);
+					ZDDNode* n_primeprime = Find(n_prime, zdd->GetNodeList(i + 1), i, state);
+					if (n_primeprime != NULL)
+					{
+						delete n_prime; // n_prime を破棄
+						n_prime = n_primeprime;
+					}
+					else
+					{
+						zdd->AddNode(i + 1, n_prime);
+					}
+				}
+				n_hat->SetChild(n_prime, x);
+			}
+		}
+		// 各ノードが deg, comp 配列を持つ（等価なノードは線形探索するので表はない）
+		RecordLevelMemory(profile, zdd, static_cast<int>(i),
+			static_cast<int64_t>(zdd->GetNumberOfIds() - 2) * 2 * sizeof(int)
+			* (state->graph->GetNumberOfVertices() + 1), 0, &level_bytes);
+	}
+	return zdd;
+}
+
+// アルゴリズムの中身については文献参照
+ZDDNode* FrontierAlgorithm::CheckTerminal(ZDD* zdd, ZDDNode* n_hat, int i, int x, State* state)
+{
+	if (!state->IsAllowed(i - 1, x)) { // 辺 i の値が固定されている
+		return zdd->GetZeroTerminal();
+	}
+	Edge edge = state->graph->GetEdgeList()[i - 1];
+	if (x == 1)
+	{
+		if (n_hat->comp[edge.src] == n_hat->comp[edge.dest])
+		{
+			return zdd->GetZeroTerminal();
+		}
+	}
+	ZDDNode* n_prime = n_hat->MakeCopy(state->graph->GetNumberOfVertices());
+	UpdateInfo(n_prime, i, x, state);
+
+	for (int y = 0; y <= 1; ++y)
+	{
+		int u = (y == 0 ? edge.src : edge.dest);
+		if ((u == state->s || u == state->t) && n_prime->deg[u] > 1)
+		{
+			delete n_prime;
+			return zdd->GetZeroTerminal();
+		}
+		else if ((u != state->s && u != state->t) && n_prime->deg[u] > 2)
+		{
+			delete n_prime;
+			return zdd->GetZeroTerminal();
+		}
+	}
+	for (int y = 0; y <= 1; ++y)
+	{
+		int u = (y == 0 ? edge.src : edge.dest);
+		if (!Contains(*state->F[i], u))
+		{
+			if ((u == state->s || u == state->t) && n_prime->deg[u] != 1)
+			{
+				delete n_prime;
+				return zdd->GetZeroTerminal();
+			}
+			else if ((u != state->s && u != state->t) && n_prime->deg[u] != 0 && n_prime->deg[u] != 2)
+			{
+				delete n_prime;
+				return zdd->GetZeroTerminal();
+			}
+		}
+	}
+	if (i == static_cast<int>(state->graph->GetEdgeList().size()))
+	{
+		// s, t に接続する辺がなければ s, t はフロンティアに入らず，上で次数を確かめていない
+		bool ok = (n_prime->deg[state->s] == 1 && n_prime->deg[state->t] == 1);
+		delete n_prime;
+		return (ok ? zdd->GetOneTerminal() : zdd->GetZeroTerminal());
+	}
+	delete n_prime;
+	return NULL;
+}
+
+// アルゴリズムの中身については文献参照
+void FrontierAlgorithm::UpdateInfo(ZDDNode* n_hat, int i, int x, State* state)
+{
+	Edge edge = state->graph->GetEdgeList()[i - 1];
+	for (int y = 0; y <= 1; ++y)
+	{
+		int u = (y == 0 ? edge.src : edge.dest);
+		if (!Contains(*state->F[i - 1], u))
+		{
+			n_hat->deg[u] = 0;
+			n_hat->comp[u] = u;
+		}
+	}
+	if (x == 1)
+	{
+		++n_hat->deg[edge.src];
+		++n_hat->deg[edge.dest];
+		int c_min = std::min(n_hat->comp[edge.src], n_hat->comp[edge.dest]);
+		int c_max = std::max(n_hat->comp[edge.src], n_hat->comp[edge.dest]);
+
+
+		for (size_t j = 0; j < state->F[i]->size(); ++j)
+		{
+			int u = (*state->F[i])[j];
+			if (n_hat->comp[u] == c_max)
+			{
+				n_hat->comp[u] = c_min;
+			}
+		}
+	}
+}
+
+// ノード配列 N_i の中に，n_prime と等価なノードが存在するか調べる。
+// 等価なノードが存在すればそれを返す。存在しなければ NULL を返す。
+// i: レベル
+ZDDNode* FrontierAlgorithm::Find(ZDDNode* n_prime, const vector<ZDDNode*>& N_i, int i, State* state)
+{
+	for (unsigned int j = 0; j < N_i.size(); ++j) {
+		ZDDNode* n_primeprime = N_i[j];
+	
+		// n_prime と n_primeprime が等価かどうか判定
+		if (IsEquivalent(n_prime, n_primeprime, i, state))
+		{
+			return n_primeprime;
+		}
+	}
+	return NULL;
+}
+
+// node1 と node2 が等価か調べる。
+// 等価なら true を，そうでなければ false を返す。
+// i: レベル
+bool FrontierAlgorithm::IsEquivalent(ZDDNode* node1, ZDDNode* node2, int i, State* state)
+{
+	vector<int>& frontier = (*state->F[i]);
+
+	for (size_t j = 0; j < frontier.size(); ++j) { // フロンティア上の頂点についてのみ比較
+		int v = frontier[j];
+		if (node1->deg[v] != node2->deg[v]) {
+			return false;
+		}
+		if (node1->comp[v] != node2->comp[v]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//******************************************************************************
+// PackedStateTable クラス
+// フロンティア上の状態（int 配列）を1状態あたり width 個ずつ連続領域に詰めて格納し，
+// オープンアドレス法のハッシュ表で重複を検出する。
+// 状態番号は追加された順に 0, 1, 2, ... と振られる。
+class PackedStateTable {
+private:
+	int width_;          // 1状態あたりの要素数
+	vector<int> states_; // 状態を width_ 個ずつ詰めて格納した配列
+	vector<int> table_;  // ハッシュ表。状態番号 + 1 を格納する（0 は空き）
+	int size_;           // 格納されている状態の数
+
+public:
+	PackedStateTable(int width)
+	{
+		width_ = width;
+		size_ = 0;
+		table_.assign(1024, 0);
+	}
+
+	int GetSize()
+	{
+		return size_;
+	}
+
+	// index 番目の状態の先頭を返す
+	const int* GetState(int index)
+	{
+		return &states_[static_cast<size_t>(index) * width_];
+	}
+
+	// state と等しい状態を探し，あればその状態番号を返す。
+	// なければ state を追加して新しい状態番号を返し，*added を true にする。
+	int FindOrAdd(const int* state, bool* added)
+	{
+		size_t mask = table_.size() - 1;
+		size_t h = Hash(state) & mask;
+		while (table_[h] != 0) {
+			int index = table_[h] - 1;
+			if (std::memcmp(GetState(index), state, sizeof(int) * width_) == 0) {
+				*added = false;
+				return index;
+			}
+			h = (h + 1) & mask;
+		}
+		states_.insert(states_.end(), state, state + width_);
+		table_[h] = size_ + 1;
+		++size_;
+		*added = true;
+
+		if (static_cast<size_t>(size_) * 2 > table_.size()) { // 負荷率が 1/2 を超えたら拡張
+			Rehash(table_.size() * 2);
+		}
+		return size_ - 1;
+	}
+
+	// 状態の配列とハッシュ表が確保しているメモリの大きさ（バイト）
+	int64_t GetStateMemoryUsage()
+	{
+		return static_cast<int64_t>(states_.capacity() * sizeof(int));
+	}
+
+	int64_t GetTableMemoryUsage()
+	{
+		return static_cast<int64_t>(table_.capacity() * sizeof(int));
+	}
+
+private:
+	size_t Hash(const int* state)
+	{
+		uint64_t h = 0;
+		for (int k = 0; k < width_; ++k) {
+			h = h * 84356289 + static_cast<uint32_t>(state[k]);
+		}
+		h ^= h >> 29;
+		h *= 0x9e3779b97f4a7c15ULL;
+		return static_cast<size_t>(h ^ (h >> 32));
+	}
+
+	void Rehash(size_t new_size)
+	{
+		table_.assign(new_size, 0);
+		size_t mask = new_size - 1;
+		for (int index = 0; index < size_; ++index) {
+			size_t h = Hash(GetState(index)) & mask;
+			while (table_[h] != 0) {
+				h = (h + 1) & mask;
+			}
+			table_[h] = index + 1;
+		}
+	}
+};
+
+//******************************************************************************
+// Knuth 氏の simpath による ZDD 構築（mate 配列版）
+// 各ノードは deg, comp の代わりに，フロンティア上の各頂点 v について
+// mate[v] だけを持つ。mate[v] の意味は以下の通り。
+//   mate[v] == v : v の次数は 0
+//   mate[v] == 0 : v の次数は 2（パスの途中）
+//   それ以外     : v はパスの断片の端点で，もう一方の端点が mate[v]
+// s と t の間には仮想的な辺があるとみなし（mate[s] = t, mate[t] = s），
+// 断片の両端をつなぐ（サイクルが完成する）ときに s-t パスが完成する。
+// mate 配列はフロンティア（に s, t を加えたもの）上の値だけを詰めて
+// PackedStateTable に格納するので，ZDDNode には deg, comp を持たせない。
+
+// simpath を実行し，ZDDを作成して返す
+ZDD* SimpathAlgorithm::Construct(State* state, MemoryProfile* profile)
+{
+	const vector<Edge>& edge_list = state->graph->GetEdgeList();
+	int m = static_cast<int>(edge_list.size());
+	int n = state->graph->GetNumberOfVertices();
+
+	// MF[i] は F[i] に，まだフロンティアから去っていない s, t を加えたもの。
+	// s, t は最初から MF に含めておく（mate[s] = t を常に保持するため）。
+	vector<vector<int> > MF(m + 1);
+	ComputeMateFrontier(state, &MF);
+
+	// 入ってくる頂点（MF[i - 1] になく辺 i に含まれる）と
+	// 去る頂点（MF[i - 1] と辺 i の端点の和から MF[i] を除いたもの）
+	vector<vector<int> > entering(m + 1), leaving(m + 1);
+	for (int i = 1; i <= m; ++i) {
+		const Edge& edge = edge_list[i - 1];
+		for (int y = 0; y <= 1; ++y) {
+			int u = (y == 0 ? edge.src : edge.dest);
+			if (!Contains(MF[i - 1], u) && !Contains(entering[i], u)) {
+				entering[i].push_back(u);
+			}
+		}
+		for (size_t k = 0; k < MF[i - 1].size(); ++k) {
+			if (!Contains(MF[i], MF[i - 1][k])) {
+				leaving[i].push_back(MF[i - 1][k]);
+			}
+		}
+		for (size_t k = 0; k < entering[i].size(); ++k) {
+			if (!Contains(MF[i], entering[i][k])) {
+				leaving[i].push_back(entering[i][k]);
+			}
+		}
+	}
+
+	ZDD* zdd = new ZDD(m + 2);
+	vector<int> mate(n + 1); // 頂点番号で引く作業用の mate 配列
+	vector<int> packed;      // 子ノードの状態を詰める作業用配列
+
+	// 根ノードの状態（MF[0] = {s, t}）
+	PackedStateTable* current = new PackedStateTable(static_cast<int>(MF[0].size()));
+	for (size_t k = 0; k < MF[0].size(); ++k) {
+		int v = MF[0][k];
+		packed.push_back(v == state->s ? state->t : (v == state->t ? state->s : v));
+	}
+	bool added;
+	current->FindOrAdd(packed.data(), &added);
+	zdd->AddNode(1, new ZDDNode());
+
+	int64_t level_bytes = (profile != NULL ? GetLevelArrayBytes(zdd, 1) : 0); // ノードの配列の大きさ
+
+	// 必ず使う辺（State::fixed_edges）のうち最後のもの。それより前で1終端にしてはならない
+	int last_forced = 0;
+	for (size_t e = 0; e < state->fixed_edges.size(); ++e) {
+		if (state->fixed_edges[e] == 1) {
+			last_forced = static_cast<int>(e) + 1;
+		}
+	}
+
+	for (int i = 1; i <= m; ++i) { // 各辺 i についての処理
+		const Edge& edge = edge_list[i - 1];
+		const vector<int>& prev_frontier = MF[i - 1];
+		const vector<int>& next_frontier = MF[i];
+		PackedStateTable* next = new PackedStateTable(static_cast<int>(next_frontier.size()));
+		packed.resize(next_frontier.size());
+
+		for (int j = 0; j < current->GetSize(); ++j) { // レベル i の各ノードについての処理
+			ZDDNode* n_hat = zdd->GetNodeList(i)[j];
+			for (int x = 0; x <= 1; ++x) { // x枝（x = 0, 1）についての処理
+				// 詰めた状態を頂点番号で引ける作業用配列に展開する
+				const int* st = current->GetState(j);
+				for (size_t k = 0; k < prev_frontier.size(); ++k) {
+					mate[prev_frontier[k]] = st[k];
+				}
+				for (size_t k = 0; k < entering[i].size(); ++k) {
+					mate[entering[i][k]] = entering[i][k];
+				}
+
+				// 辺 i の値が固定されていれば，もう一方の枝は0終端
+				ZDDNode* n_prime = (state->IsAllowed(i - 1, x)
+					? CheckTerminalPre(zdd, &mate, edge, x, prev_frontier) : zdd->GetZeroTerminal());
+				if (n_prime == zdd->GetOneTerminal() && i < last_forced) {
+					n_prime = zdd->GetZeroTerminal(); // 後の辺を使わずにパスが完成した
+				}
+				if (n_prime == NULL) {
+					Update(&mate, edge, x);
+					n_prime = CheckTerminalPost(zdd, mate, leaving[i], i == m);
+				}
+				if (n_prime == NULL) { // x枝の先が0終端でも1終端でもないと判定された
+					for (size_t k = 0; k < next_frontier.size(); ++k) {
+						packed[k] = mate[next_frontier[k]];
+					}
+					int index = next->FindOrAdd(packed.data(), &added);
+					if (added) {
+						zdd->AddNode(i + 1, new ZDDNode());
+					}
+					n_prime = zdd->GetNodeList(i + 1)[index];
+				}
+				n_hat->SetChild(n_prime, x);
+			}
+		}
+		RecordLevelMemory(profile, zdd, i,
+			current->GetStateMemoryUsage() + next->GetStateMemoryUsage(),
+			current->GetTableMemoryUsage() + next->GetTableMemoryUsage(), &level_bytes);
+		delete current;
+		current = next;
+	}
+	delete current;
+	return zdd;
+}
+
+void SimpathAlgorithm::ComputeMateFrontier(State* state, vector<vector<int> >* MF)
+{
+	const vector<Edge>& edge_list = state->graph->GetEdgeList();
+	int m = static_cast<int>(edge_list.size());
+
+	// 頂点 v が最後に現れる辺の番号（1始まり）。現れなければ m とする。
+	int last_s = m, last_t = m;
+	for (int i = m; i >= 1; --i) {
+		const Edge& edge = edge_list[i - 1];
+		if (edge.src == state->s || edge.dest == state->s) {
+			last_s = i;
+			break;
+		}
+	}
+	for (int i = m; i >= 1; --i) {
+		const Edge& edge = edge_list[i - 1];
+		if (edge.src == state->t || edge.dest == state->t) {
+			last_t = i;
+			break;
+		}
+	}
+	for (int i = 0; i <= m; ++i) {
+		(*MF)[i] = *state->F[i];
+		if (i < last_s && !Contains((*MF)[i], state->s)) {
+			(*MF)[i].push_back(state->s);
+		}
+		if (i < last_t && !Contains((*MF)[i], state->t)) {
+			(*MF)[i].push_back(state->t);
+		}
+	}
+}
+
+// 辺を張る前のチェック。0終端，1終端，または NULL（未確定）を返す。
+ZDDNode* SimpathAlgorithm::CheckTerminalPre(ZDD* zdd, vector<int>* mate, const Edge& edge, int x,
+	const vector<int>& prev_frontier)
+{
+	if (x == 0) {
+		return NULL;
+	}
+	vector<int>& mt = *mate;
+	if (mt[edge.src] == 0 || mt[edge.dest] == 0) { // 分岐が発生
+		return zdd->GetZeroTerminal();
+	}
+	if (mt[edge.src] == edge.dest) { // サイクル（仮想辺を含む s-t パス）が完成
+		// フロンティアの頂点（この辺で去るものも含む。s, t は最後の辺で去りうる）が，
+		// パスの途中でも孤立点でもない（次数 1）なら不完全なパスが残るので0終端。
+		// 新たに入る頂点は辺 i の端点でなければ孤立点なので見なくてよい
+		for (size_t k = 0; k < prev_frontier.size(); ++k) {
+			int v = prev_frontier[k];
+			if (v != edge.src && v != edge.dest && mt[v] != 0 && mt[v] != v) {
+				return zdd->GetZeroTerminal();
+			}
+		}
+		return zdd->GetOneTerminal();
+	}
+	return NULL;
+}
+
+// 辺を張ったときの mate の更新
+// （↓の計算順を変更すると正しく動作しないことに注意）
+void SimpathAlgorithm::Update(vector<int>* mate, const Edge& edge, int x)
+{
+	if (x == 1) {
+		vector<int>& mt = *mate;
+		int sm = mt[edge.src];
+		int dm = mt[edge.dest];
+		mt[edge.src] = 0;
+		mt[edge.dest] = 0;
+		mt[sm] = dm;
+		mt[dm] = sm;
+	}
+}
+
+// 辺を張った後のチェック。0終端，または NULL（未確定）を返す。
+ZDDNode* SimpathAlgorithm::CheckTerminalPost(ZDD* zdd, const vector<int>& mate,
+	const vector<int>& leaving, bool is_last_edge)
+{
+	for (size_t k = 0; k < leaving.size(); ++k) {
+		int v = leaving[k]; // フロンティアから去る頂点 v
+		if (mate[v] != 0 && mate[v] != v) { // v の次数が 1
+			return zdd->GetZeroTerminal();
+		}
+	}
+	if (is_last_edge) {
+		return zdd->GetZeroTerminal();
+	}
+	return NULL;
+}
+
+//******************************************************************************
+// 詰めた状態表現によるフロンティア法（deg/comp 版）
+// 各ノードの状態は，フロンティア上の位置 k ごとに1要素（セル）の配列で表す。
+// セルの下位2ビットが deg，残りのビットが comp である。
+// 有向グラフでは deg のビット0 を入次数，ビット1 を出次数とする（それぞれ 0 か 1）。
+// 端点の組が2組以上のときは，端点を含む連結成分の comp を位置ではなく
+// label_base + 端点の番号（組 k の始点は 2k，終点は 2k + 1）にして，
+// 異なる組の端点を含む成分をつながないようにする（label_base はフロンティアの大きさの最大値）。
+// comp には頂点番号ではなく，同じ連結成分に属するフロンティア上の頂点のうち
+// 最も前の位置を格納する（状態の正規形になるので等価判定は配列の比較で済む）。
+// フロンティアの大きさの最大値 W が 16, 32, 64 以下のときは，
+// W を テンプレート引数とした std::array<uint8_t, W> で状態を持ち，
+// 比較，ハッシュ，comp の付け替えのループを固定回数にする（コンパイラが展開する）。
+// それより大きいときは幅を実行時に決める版（セルは uint32_t）を用いる。
+
+// レベル i（辺 i）の処理で用いるフロンティアの対応関係。
+// 作業用配列は F[i - 1] の後ろに，新たにフロンティアに入る頂点を並べたもの。
+// State::ComputeFrontier は F[i] を同じ順序で作るので，F[i] は作業用配列から
+// 去る頂点を除いたものになる。
+struct PackedLevel {
+	int prev_width;             // F[i - 1] の大きさ
+	int work_width;             // 作業用配列の大きさ
+	int src_pos;                // 作業用配列での辺 i の src の位置
+	int dest_pos;               // 作業用配列での辺 i の dest の位置
+	bool src_is_terminal;       // src が s または t か
+	bool dest_is_terminal;      // dest が s または t か
+	bool directed;              // 有向グラフか（辺 i は src から dest への弧）
+	bool usable;                // 辺 i を使えるか（有向で t から出る，または s に入る弧は使えない）
+	bool infeasible;            // 解がないか（辺のない端点がある。レベル 1 にのみ設定する）
+	int fixed_value;            // 辺 i の値の固定（State::fixed_edges。-1 なら固定しない）
+	int label_base;             // 端点を含む成分の comp の最小値（端点の組が1組なら使わない）
+	vector<int> entering_comp;  // 新たに入る頂点の comp（作業用配列での位置 prev_width 以降）
+	vector<int> leaving_pos;    // フロンティアから去る頂点の作業用配列での位置
+	vector<bool> leaving_is_terminal; // 去る頂点が s または t か
+	vector<int> next_from;      // F[i] の p 番目の頂点の作業用配列での位置
+
+	// state のフロンティアから PackedLevel の配列を作る。levels[i] がレベル i 用（i は1始まり）。
+	static void Compute(State* state, vector<PackedLevel>* levels)
+	{
+		const vector<Edge>& edge_list = state->graph->GetEdgeList();
+		levels->assign(edge_list.size() + 1, PackedLevel());
+
+		// terminal[v] は頂点 v の端点の番号（端点でなければ -1）。
+		// 組 k の始点は 2k，終点は 2k + 1
+		const vector<std::pair<int, int> >& pairs = state->terminal_pairs;
+		vector<int> terminal(state->graph->GetNumberOfVertices() + 1, -1);
+		for (size_t k = 0; k < pairs.size(); ++k) {
+			terminal[pairs[k].first] = static_cast<int>(2 * k);
+			terminal[pairs[k].second] = static_cast<int>(2 * k + 1);
+		}
+		vector<bool> has_edge(terminal.size(), false);
+		int label_base = 0;
+		for (size_t i = 1; i <= edge_list.size(); ++i) {
+			label_base = std::max(label_base, static_cast<int>(state->F[i - 1]->size()) + 2);
+			has_edge[edge_list[i - 1].src] = has_edge[edge_list[i - 1].dest] = true;
+		}
+		bool labeled = pairs.size() >= 2;
+
+		for (size_t i = 1; i <= edge_list.size(); ++i) {
+			PackedLevel& lv = (*levels)[i];
+			const Edge& edge = edge_list[i - 1];
+			vector<int> work = *state->F[i - 1];
+			lv.prev_width = static_cast<int>(work.size());
+			for (int y = 0; y <= 1; ++y) {
+				int u = (y == 0 ? edge.src : edge.dest);
+				if (!Contains(work, u)) {
+					work.push_back(u);
+					int k = static_cast<int>(work.size()) - 1;
+					lv.entering_comp.push_back(labeled && terminal[u] >= 0
+						? label_base + terminal[u] : k);
+				}
+			}
+			lv.work_width = static_cast<int>(work.size());
+			lv.src_pos = IndexOf(work, edge.src);
+			lv.dest_pos = IndexOf(work, edge.dest);
+			lv.src_is_terminal = terminal[edge.src] >= 0;
+			lv.dest_is_terminal = terminal[edge.dest] >= 0;
+			lv.directed = state->graph->IsDirected();
+			// 有向なら終点から出る弧，始点に入る弧は使えない（終点の番号は奇数）
+			lv.usable = !lv.directed || ((!lv.src_is_terminal || terminal[edge.src] % 2 == 0)
+				&& (!lv.dest_is_terminal || terminal[edge.dest] % 2 == 1));
+			lv.infeasible = false;
+			lv.fixed_value = (state->fixed_edges.empty() ? -1 : state->fixed_edges[i - 1]);
+			lv.label_base = (labeled ? label_base : -1);
+			for (size_t k = 0; k < work.size(); ++k) {
+				if (!Contains(*state->F[i], work[k])) {
+					lv.leaving_pos.push_back(static_cast<int>(k));
+					lv.leaving_is_terminal.push_back(terminal[work[k]] >= 0);
+				}
+			}
+			for (size_t p = 0; p < state->F[i]->size(); ++p) {
+				lv.next_from.push_back(IndexOf(work, (*state->F[i])[p]));
+			}
+		}
+
+		// 辺のない端点はフロンティアに入らず調べられないので，ここで解なしとする
+		for (size_t k = 0; k < pairs.size() && !edge_list.empty(); ++k) {
+			if (!has_edge[pairs[k].first] || !has_edge[pairs[k].second]) {
+				(*levels)[1].infeasible = true;
+			}
+		}
+	}
+
+	// comp の値の最大値 + 1（状態表の comp のビット数が足りるかの判定に用いる）
+	static int GetCompLimit(const vector<PackedLevel>& levels, int max_width)
+	{
+		int limit = max_width;
+		for (size_t i = 1; i < levels.size(); ++i) {
+			for (size_t k = 0; k < levels[i].entering_comp.size(); ++k) {
+				limit = std::max(limit, levels[i].entering_comp[k] + 1);
+			}
+		}
+		return limit;
+	}
+
+private:
+	static int IndexOf(const vector<int>& vec, int element)
+	{
+		return static_cast<int>(std::find(vec.begin(), vec.end(), element) - vec.begin());
+	}
+};
+
+//******************************************************************************
+// 幅固定の状態（uint8_t のセルが W 個）に対する基本演算（カーネル）。
+// 比較（IsEqual），ハッシュ値の計算（Hash），comp の付け替え（c_from -> c_to，Relabel）
+// の3つを，スカラー版，SSE2 版，AVX2 版で用意する。
+// ハッシュ値はどの版でも同じ値になるように定義する：状態を 64 ビット語 w_k に区切り，
+// (w_k の下位32ビット) * kHashLo[k % 4] + (w_k の上位32ビット) * kHashHi[k % 4] の
+// 総和（mod 2^64）を MixHash で混ぜたもの。
+
+static const uint32_t kHashLo[4] = { 0x9e3779b1U, 0x85ebca77U, 0xc2b2ae3dU, 0x27d4eb2fU };
+static const uint32_t kHashHi[4] = { 0x165667b1U, 0xd3a2646cU, 0xfd7046c5U, 0xb55a4f09U };
+
+// 実行中の CPU で使える最も新しい SIMD 命令セットを返す
+SimdLevel DetectSimdLevel()
+{
+#if FRONTIER_X86_SIMD
+	if (__builtin_cpu_supports("avx2")) {
+		return kSimdAvx2;
+	}
+	return kSimdSse2;
+#else
+	return kSimdScalar;
+#endif
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+	switch (level) {
+	case kSimdAvx2:
+		return "avx2";
+	case kSimdSse2:
+		return "sse2";
+	default:
+		return "scalar";
+	}
+}
+
+template <int W>
+struct ScalarKernels {
+	static bool IsEqual(const uint8_t* a, const uint8_t* b)
+	{
+		uint64_t diff = 0;
+		for (int k = 0; k < W / 8; ++k) {
+			uint64_t x, y;
+			std::memcpy(&x, a + 8 * k, 8);
+			std::memcpy(&y, b + 8 * k, 8);
+			diff |= x ^ y;
+		}
+		return diff == 0;
+	}
+
+	static uint64_t Hash(const uint8_t* state)
+	{
+		uint64_t h = 0;
+		for (int k = 0; k < W / 8; ++k) {
+			uint64_t x;
+			std::memcpy(&x, state + 8 * k, 8);
+			h += (x & 0xffffffffULL) * kHashLo[k % 4] + (x >> 32) * kHashHi[k % 4];
+		}
+		return MixHash(h);
+	}
+
+	// comp が c_from のセルの comp を c_to にする（deg はそのまま）
+	static void Relabel(uint8_t* cells, int c_from, int c_to)
+	{
+		for (int k = 0; k < W; ++k) {
+			if ((cells[k] >> 2) == c_from) {
+				cells[k] = static_cast<uint8_t>((cells[k] & 3) | (c_to << 2));
+			}
+		}
+	}
+};
+
+#if FRONTIER_X86_SIMD
+
+// SSE2 版。16 バイトずつ処理する。
+template <int W>
+struct Sse2Kernels {
+	static bool IsEqual(const uint8_t* a, const uint8_t* b)
+	{
+		__m128i acc = _mm_set1_epi8(-1);
+		for (int k = 0; k < W / 16; ++k) {
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16 * k));
+			__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16 * k));
+			acc = _mm_and_si128(acc, _mm_cmpeq_epi8(x, y));
+		}
+		return _mm_movemask_epi8(acc) == 0xffff;
+	}
+
+	static uint64_t Hash(const uint8_t* state)
+	{
+		const __m128i lo[2] = { _mm_set_epi32(0, kHashLo[1], 0, kHashLo[0]),
+			_mm_set_epi32(0, kHashLo[3], 0, kHashLo[2]) };
+		const __m128i hi[2] = { _mm_set_epi32(0, kHashHi[1], 0, kHashHi[0]),
+			_mm_set_epi32(0, kHashHi[3], 0, kHashHi[2]) };
+		__m128i acc = _mm_setzero_si128();
+		for (int k = 0; k < W / 16; ++k) {
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 16 * k));
+			acc = _mm_add_epi64(acc, _mm_mul_epu32(x, lo[k % 2]));
+			acc = _mm_add_epi64(acc, _mm_mul_epu32(_mm_srli_epi64(x, 32), hi[k % 2]));
+		}
+		uint64_t h[2];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(h), acc);
+		return MixHash(h[0] + h[1]);
+	}
+
+	// comp ビットが c_from のセルだけ，(c_from ^ c_to) << 2 と xor をとる
+	static void Relabel(uint8_t* cells, int c_from, int c_to)
+	{
+		const __m128i comp_mask = _mm_set1_epi8(static_cast<char>(0xfc));
+		const __m128i target = _mm_set1_epi8(static_cast<char>(c_from << 2));
+		const __m128i flip = _mm_set1_epi8(static_cast<char>((c_from ^ c_to) << 2));
+		for (int k = 0; k < W / 16; ++k) {
+			__m128i* p = reinterpret_cast<__m128i*>(cells + 16 * k);
+			__m128i x = _mm_loadu_si128(p);
+			__m128i eq = _mm_cmpeq_epi8(_mm_and_si128(x, comp_mask), target);
+			_mm_storeu_si128(p, _mm_xor_si128(x, _mm_and_si128(eq, flip)));
+		}
+	}
+};
+
+// AVX2 版。32 バイトずつ処理する（W は 32 の倍数）。
+// 呼び出し側は DetectSimdLevel() が kSimdAvx2 を返したときだけ使うこと。
+template <int W>
+struct Avx2Kernels {
+	__attribute__((target("avx2")))
+	static bool IsEqual(const uint8_t* a, const uint8_t* b)
+	{
+		__m256i acc = _mm256_set1_epi8(-1);
+		for (int k = 0; k < W / 32; ++k) {
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 32 * k));
+			__m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32 * k));
+			acc = _mm256_and_si256(acc, _mm256_cmpeq_epi8(x, y));
+		}
+		return _mm256_movemask_epi8(acc) == -1;
+	}
+
+	__attribute__((target("avx2")))
+	static uint64_t Hash(const uint8_t* state)
+	{
+		const __m256i lo = _mm256_set_epi32(0, kHashLo[3], 0, kHashLo[2],
+			0, kHashLo[1], 0, kHashLo[0]);
+		const __m256i hi = _mm256_set_epi32(0, kHashHi[3], 0, kHashHi[2],
+			0, kHashHi[1], 0, kHashHi[0]);
+		__m256i acc = _mm256_setzero_si256();
+		for (int k = 0; k < W / 32; ++k) {
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state + 32 * k));
+			acc = _mm256_add_epi64(acc, _mm256_mul_epu32(x, lo));
+			acc = _mm256_add_epi64(acc, _mm256_mul_epu32(_mm256_srli_epi64(x, 32), hi));
+		}
+		uint64_t h[4];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(h), acc);
+		return MixHash(h[0] + h[1] + h[2] + h[3]);
+	}
+
+	__attribute__((target("avx2")))
+	static void Relabel(uint8_t* cells, int c_from, int c_to)
+	{
+		const __m256i comp_mask = _mm256_set1_epi8(static_cast<char>(0xfc));
+		const __m256i target = _mm256_set1_epi8(static_cast<char>(c_from << 2));
+		const __m256i flip = _mm256_set1_epi8(static_cast<char>((c_from ^ c_to) << 2));
+		for (int k = 0; k < W / 32; ++k) {
+			__m256i* p = reinterpret_cast<__m256i*>(cells + 32 * k);
+			__m256i x = _mm256_loadu_si256(p);
+			__m256i eq = _mm256_cmpeq_epi8(_mm256_and_si256(x, comp_mask), target);
+			_mm256_storeu_si256(p, _mm256_xor_si256(x, _mm256_and_si256(eq, flip)));
+		}
+	}
+};
+
+#endif // FRONTIER_X86_SIMD
+
+// 幅 W 固定の状態表。状態は std::array<uint8_t, W> で持つ（使わない位置は 0）。
+// セルの comp は 6 ビットなので W は 64 以下でなければならない。
+// 比較，ハッシュ値の計算，comp の付け替えには Kernels（上記のいずれか）を用いる。
+template <int W, typename Kernels>
+class FixedWidthStateTable {
+public:
+	typedef uint8_t Cell;
+	static const int kWidth = W; // 状態1つあたりのセル数（0 なら実行時に決まる）
+
+private:
+	vector<std::array<uint8_t, W> > states_;
+	vector<int> table_; // ハッシュ表。状態番号 + 1 を格納する（0 は空き）
+
+public:
+	FixedWidthStateTable(int /* width */)
+	{
+		table_.assign(1024, 0);
+	}
+
+	// 空にする（確保した領域は解放せずに次の構築で使う）
+	void Clear(int /* width */)
+	{
+		states_.clear();
+		table_.assign(1024, 0);
+	}
+
+	int GetSize()
+	{
+		return static_cast<int>(states_.size());
+	}
+
+	const Cell* GetState(int index)
+	{
+		return states_[index].data();
+	}
+
+	int FindOrAdd(const Cell* state, bool* added)
+	{
+		size_t mask = table_.size() - 1;
+		size_t h = Hash(state) & mask;
+		while (table_[h] != 0) {
+			int index = table_[h] - 1;
+			if (IsEqual(states_[index].data(), state)) {
+				*added = false;
+				return index;
+			}
+			h = (h + 1) & mask;
+		}
+		states_.push_back(std::array<uint8_t, W>());
+		std::memcpy(states_.back().data(), state, W);
+		table_[h] = static_cast<int>(states_.size());
+		*added = true;
+
+		if (states_.size() * 2 > table_.size()) { // 負荷率が 1/2 を超えたら拡張
+			Rehash(table_.size() * 2);
+		}
+		return static_cast<int>(states_.size()) - 1;
+	}
+
+	// 確保しているメモリの大きさ（バイト）。状態の配列の分とハッシュ表の分の和
+	int64_t GetMemoryUsage()
+	{
+		return GetStateMemoryUsage() + GetTableMemoryUsage();
+	}
+
+	int64_t GetStateMemoryUsage()
+	{
+		return static_cast<int64_t>(states_.capacity() * W);
+	}
+
+	int64_t GetTableMemoryUsage()
+	{
+		return static_cast<int64_t>(table_.capacity() * sizeof(int));
+	}
+
+	static bool IsEqual(const Cell* a, const Cell* b)
+	{
+		return Kernels::IsEqual(a, b);
+	}
+
+	static uint64_t Hash(const Cell* state)
+	{
+		return Kernels::Hash(state);
+	}
+
+	// 作業用配列 cells（W 個）の comp が c_from のセルを c_to にする
+	static void Relabel(Cell* cells, int /* width */, int c_from, int c_to)
+	{
+		Kernels::Relabel(cells, c_from, c_to);
+	}
+
+private:
+	void Rehash(size_t new_size)
+	{
+		table_.assign(new_size, 0);
+		size_t mask = new_size - 1;
+		for (size_t index = 0; index < states_.size(); ++index) {
+			size_t h = Hash(states_[index].data()) & mask;
+			while (table_[h] != 0) {
+				h = (h + 1) & mask;
+			}
+			table_[h] = static_cast<int>(index) + 1;
+		}
+	}
+};
+
+// 幅を実行時に決める状態表（フロンティアが 64 を超えるとき用）。
+// 状態は width 個の uint32_t セルを連続領域に詰めて格納する。
+class DynamicWidthStateTable {
+public:
+	typedef uint32_t Cell;
+	static const int kWidth = 0;
+
+private:
+	int width_;
+	vector<Cell> states_;
+	vector<int> table_;
+	int size_;
+
+public:
+	DynamicWidthStateTable(int width)
+	{
+		width_ = width;
+		size_ = 0;
+		table_.assign(1024, 0);
+	}
+
+	// 空にして幅を width にする（確保した領域は解放せずに次の構築で使う）
+	void Clear(int width)
+	{
+		width_ = width;
+		size_ = 0;
+		states_.clear();
+		table_.assign(1024, 0);
+	}
+
+	int GetSize()
+	{
+		return size_;
+	}
+
+	const Cell* GetState(int index)
+	{
+		return &states_[static_cast<size_t>(index) * width_];
+	}
+
+	int FindOrAdd(const Cell* state, bool* added)
+	{
+		size_t mask = table_.size() - 1;
+		size_t h = Hash(state) & mask;
+		while (table_[h] != 0) {
+			int index = table_[h] - 1;
+			if (std::memcmp(GetState(index), state, sizeof(Cell) * width_) == 0) {
+				*added = false;
+				return index;
+			}
+			h = (h + 1) & mask;
+		}
+		states_.insert(states_.end(), state, state + width_);
+		table_[h] = size_ + 1;
+		++size_;
+		*added = true;
+
+		if (static_cast<size_t>(size_) * 2 > table_.size()) {
+			Rehash(table_.size() * 2);
+		}
+		return size_ - 1;
+	}
+
+	// 確保しているメモリの大きさ（バイト）
+	int64_t GetMemoryUsage()
+	{
+		return GetStateMemoryUsage() + GetTableMemoryUsage();
+	}
+
+	int64_t GetStateMemoryUsage()
+	{
+		return static_cast<int64_t>(states_.capacity() * sizeof(Cell));
+	}
+
+	int64_t GetTableMemoryUsage()
+	{
+		return static_cast<int64_t>(table_.capacity() * sizeof(int));
+	}
+
+	// 作業用配列 cells（width 個）の comp が c_from のセルを c_to にする
+	static void Relabel(Cell* cells, int width, int c_from, int c_to)
+	{
+		for (int k = 0; k < width; ++k) {
+			if ((cells[k] >> 2) == static_cast<Cell>(c_from)) {
+				cells[k] = (cells[k] & 3) | (static_cast<Cell>(c_to) << 2);
+			}
+		}
+	}
+
+private:
+	uint64_t Hash(const Cell* state)
+	{
+		uint64_t h = 0;
+		for (int k = 0; k < width_; ++k) {
+			h = (h ^ state[k]) * 0x9e3779b97f4a7c15ULL;
+		}
+		return MixHash(h);
+	}
+
+	void Rehash(size_t new_size)
+	{
+		table_.assign(new_size, 0);
+		size_t mask = new_size - 1;
+		for (int index = 0; index < size_; ++index) {
+			size_t h = Hash(GetState(index)) & mask;
+			while (table_[h] != 0) {
+				h = (h + 1) & mask;
+			}
+			table_[h] = index + 1;
+		}
+	}
+};
+
+// ConstructWorkspace に状態表を出し入れする
+class WorkspaceAccess {
+public:
+	// workspace に Table 型の状態表が取ってあれば空にして幅を width にして返し，なければ作る
+	template <typename Table>
+	static Table* Take(ConstructWorkspace* workspace, int width)
+	{
+		if (workspace != NULL) {
+			ConstructWorkspace::Pool* pool = GetPool<Table>(workspace);
+			if (!pool->tables.empty()) {
+				Table* table = static_cast<Table*>(pool->tables.back());
+				pool->tables.pop_back();
+				table->Clear(width);
+				return table;
+			}
+		}
+		return new Table(width);
+	}
+
+	// table を workspace に返す（workspace が NULL なら解放する）
+	template <typename Table>
+	static void Give(ConstructWorkspace* workspace, Table* table)
+	{
+		if (workspace == NULL) {
+			delete table;
+			return;
+		}
+		GetPool<Table>(workspace)->tables.push_back(table);
+	}
+
+private:
+	template <typename Table>
+	static void Destroy(void* table)
+	{
+		delete static_cast<Table*>(table);
+	}
+
+	template <typename Table>
+	static int64_t GetMemoryUsage(void* table)
+	{
+		return static_cast<Table*>(table)->GetMemoryUsage();
+	}
+
+	template <typename Table>
+	static ConstructWorkspace::Pool* GetPool(ConstructWorkspace* workspace)
+	{
+		static const char type = 0; // アドレスが Table 型ごとに異なる
+		for (size_t k = 0; k < workspace->pools_.size(); ++k) {
+			if (workspace->pools_[k].type == &type) {
+				return &workspace->pools_[k];
+			}
+		}
+		ConstructWorkspace::Pool pool = { &type, vector<void*>(), &Destroy<Table>,
+			&GetMemoryUsage<Table> };
+		workspace->pools_.push_back(pool);
+		return &workspace->pools_.back();
+	}
+};
+
+ConstructWorkspace::ConstructWorkspace()
+{
+}
+
+ConstructWorkspace::~ConstructWorkspace()
+{
+	for (size_t k = 0; k < pools_.size(); ++k) {
+		for (size_t j = 0; j < pools_[k].tables.size(); ++j) {
+			pools_[k].destroy(pools_[k].tables[j]);
+		}
+	}
+}
+
+int ConstructWorkspace::GetNumberOfTables()
+{
+	int total = 0;
+	for (size_t k = 0; k < pools_.size(); ++k) {
+		total += static_cast<int>(pools_[k].tables.size());
+	}
+	return total;
+}
+
+int64_t ConstructWorkspace::GetMemoryUsage()
+{
+	int64_t total = 0;
+	for (size_t k = 0; k < pools_.size(); ++k) {
+		for (size_t j = 0; j < pools_[k].tables.size(); ++j) {
+			total += pools_[k].memory_usage(pools_[k].tables[j]);
+		}
+	}
+	return total;
+}
+
+//******************************************************************************
+// チェックポイント
+// ディレクトリに次の2つのファイルを置く。
+//   levels.bin : ヘッダ（マジック，指紋）のあとに，構築の終わったレベルごとに
+//                ノード数 n（uint32）と 2n 個の子の番号（uint32。0終端は 0，1終端は 1，
+//                次のレベルの j 番目のノードは j + 2）を追記していく。
+//   states.bin : ヘッダ（マジック，指紋）のあとに，終わったレベルの数 L，その時点の
+//                levels.bin の長さ，レベル L + 1 の状態の数と状態（セルの並び）を置く。
+//                一時ファイルに書いてから rename で置き換える。
+// 再開時は levels.bin を states.bin に記録された長さに切り詰め，そこから追記を続ける。
+// 指紋は入力（辺リスト，s, t）と状態の表現（セルの大きさ，幅）から計算し，
+// 別の入力のチェックポイントから再開しないようにする。
+
+static const char kLevelsMagic[8] = { 'F', 'R', 'C', 'K', 'L', 'V', '0', '1' };
+static const char kStatesMagic[8] = { 'F', 'R', 'C', 'K', 'S', 'T', '0', '1' };
+
+static uint64_t ComputeCheckpointFingerprint(State* state, int cell_size, int width)
+{
+	const vector<Edge>& edge_list = state->graph->GetEdgeList();
+	uint64_t h = MixHash(state->graph->GetNumberOfVertices() + 1);
+	for (size_t k = 0; k < state->terminal_pairs.size(); ++k) {
+		h = MixHash(h ^ (static_cast<uint64_t>(state->terminal_pairs[k].first) << 32
+			| state->terminal_pairs[k].second));
+	}
+	h = MixHash(h ^ (static_cast<uint64_t>(cell_size) << 32 | width));
+	h = MixHash(h ^ (state->graph->IsDirected() ? 1 : 0));
+	for (size_t e = 0; e < edge_list.size(); ++e) {
+		h = MixHash(h ^ (static_cast<uint64_t>(edge_list[e].src) << 32 | edge_list[e].dest));
+		if (!state->fixed_edges.empty()) { // 固定がなければ以前のチェックポイントと同じ値になる
+			h = MixHash(h ^ static_cast<uint64_t>(state->fixed_edges[e] + 2));
+		}
+	}
+	return h;
+}
+
+// チェックポイントから読み込んだ内容
+struct CheckpointData {
+	int number_of_levels; // 構築の終わったレベルの数 L
+	int64_t levels_length; // levels.bin の有効な長さ
+	vector<vector<uint32_t> > children; // children[i - 1] はレベル i のノードの子の番号
+	int number_of_states; // レベル L + 1 の状態の数
+	vector<uint8_t> states; // レベル L + 1 の状態
+
+	// directory のチェックポイントを読み込む。なければ，または壊れていれば false を返す
+	bool Read(const string& directory, uint64_t fingerprint, int cell_size, int width)
+	{
+		FILE* fp = fopen((directory + "/states.bin").c_str(), "rb");
+		if (fp == NULL) {
+			return false;
+		}
+		char magic[8];
+		uint64_t fp_value;
+		int32_t header[2];
+		bool ok = fread(magic, 1, 8, fp) == 8 && std::memcmp(magic, kStatesMagic, 8) == 0
+			&& fread(&fp_value, sizeof(fp_value), 1, fp) == 1 && fp_value == fingerprint
+			&& fread(header, sizeof(int32_t), 2, fp) == 2
+			&& fread(&levels_length, sizeof(levels_length), 1, fp) == 1;
+		if (ok) {
+			number_of_levels = header[0];
+			number_of_states = header[1];
+			ok = number_of_levels >= 1 && number_of_states >= 1;
+		}
+		if (ok) {
+			states.resize(static_cast<size_t>(number_of_states) * width * cell_size);
+			ok = fread(states.data(), 1, states.size(), fp) == states.size();
+		}
+		fclose(fp);
+		if (!ok) {
+			return false;
+		}
+
+		fp = fopen((directory + "/levels.bin").c_str(), "rb");
+		if (fp == NULL) {
+			return false;
+		}
+		ok = fread(magic, 1, 8, fp) == 8 && std::memcmp(magic, kLevelsMagic, 8) == 0
+			&& fread(&fp_value, sizeof(fp_value), 1, fp) == 1 && fp_value == fingerprint;
+		children.assign(number_of_levels, vector<uint32_t>());
+		for (int i = 0; ok && i < number_of_levels; ++i) {
+			uint32_t n;
+			ok = fread(&n, sizeof(n), 1, fp) == 1;
+			if (ok) {
+				children[i].resize(static_cast<size_t>(n) * 2);
+				ok = fread(children[i].data(), sizeof(uint32_t), children[i].size(), fp)
+					== children[i].size();
+			}
+		}
+		ok = ok && ftell(fp) == levels_length;
+		fclose(fp);
+		return ok && IsConsistent();
+	}
+
+private:
+	// レベル 1 のノードが根だけで，子の番号が次のレベルのノード数に収まるか
+	bool IsConsistent()
+	{
+		if (children[0].size() != 2) {
+			return false;
+		}
+		for (int i = 0; i < number_of_levels; ++i) {
+			uint32_t next_size = (i + 1 < number_of_levels
+				? static_cast<uint32_t>(children[i + 1].size() / 2)
+				: static_cast<uint32_t>(number_of_states));
+			for (size_t k = 0; k < children[i].size(); ++k) {
+				if (children[i][k] >= next_size + 2) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+};
+
+// チェックポイントを別スレッドで書き出す。
+// AppendLevel, WriteStates は書き出す内容をキューに積むだけで，すぐに戻る。
+// キューは順に処理されるので，states.bin にはそれより前に積んだレベルまでが記録される。
+// 書き出しに失敗したら標準エラー出力に知らせ，以降のチェックポイントはあきらめる
+// （構築は続ける）。
+class CheckpointWriter {
+private:
+	struct Job {
+		bool is_states;          // true なら states.bin，false なら levels.bin への追記
+		int level;               // is_states のとき，終わったレベルの数
+		vector<uint32_t> children;
+		vector<uint8_t> states;
+		int number_of_states;
+	};
+
+	string directory_;
+	uint64_t fingerprint_;
+	FILE* levels_fp_;
+	bool failed_;
+
+	mutex mutex_;
+	condition_variable cond_;
+	deque<Job> queue_;
+	bool stop_;
+	thread thread_;
+
+public:
+	CheckpointWriter(const string& directory, uint64_t fingerprint)
+	{
+		directory_ = directory;
+		fingerprint_ = fingerprint;
+		levels_fp_ = NULL;
+		failed_ = false;
+		stop_ = false;
+	}
+
+	// 残りの書き出しを終えてからスレッドを止める
+	~CheckpointWriter()
+	{
+		if (thread_.joinable()) {
+			{
+				lock_guard<mutex> lock(mutex_);
+				stop_ = true;
+			}
+			cond_.notify_one();
+			thread_.join();
+		}
+		if (levels_fp_ != NULL) {
+			fclose(levels_fp_);
+		}
+	}
+
+	// levels.bin を開いて書き出しスレッドを始める。levels_length が 0 なら新しく作り，
+	// そうでなければ（再開時）その長さに切り詰めて追記する。
+	bool Open(int64_t levels_length)
+	{
+		mkdir(directory_.c_str(), 0777); // すでにあれば失敗するが構わない
+		string path = directory_ + "/levels.bin";
+		if (levels_length == 0) {
+			remove((directory_ + "/states.bin").c_str()); // 以前の構築のものは使わない
+			levels_fp_ = fopen(path.c_str(), "wb");
+			if (levels_fp_ == NULL || fwrite(kLevelsMagic, 1, 8, levels_fp_) != 8
+				|| fwrite(&fingerprint_, sizeof(fingerprint_), 1, levels_fp_) != 1) {
+				return Fail(path);
+			}
+		} else {
+			if (truncate(path.c_str(), levels_length) != 0
+				|| (levels_fp_ = fopen(path.c_str(), "ab")) == NULL) {
+				return Fail(path);
+			}
+		}
+		thread_ = thread(&CheckpointWriter::Run, this);
+		return true;
+	}
+
+	// レベルの子の番号（children の中身は移される）を追記する
+	void AppendLevel(vector<uint32_t>* children)
+	{
+		Job job;
+		job.is_states = false;
+		job.level = 0;
+		job.children.swap(*children);
+		job.number_of_states = 0;
+		Push(&job);
+	}
+
+	// レベル level まで終わった時点の，レベル level + 1 の状態（中身は移される）を書き出す
+	void WriteStates(int level, vector<uint8_t>* states, int number_of_states)
+	{
+		Job job;
+		job.is_states = true;
+		job.level = level;
+		job.states.swap(*states);
+		job.number_of_states = number_of_states;
+		Push(&job);
+	}
+
+private:
+	void Push(Job* job)
+	{
+		{
+			lock_guard<mutex> lock(mutex_);
+			queue_.push_back(std::move(*job));
+		}
+		cond_.notify_one();
+	}
+
+	void Run()
+	{
+		for (;;) {
+			Job job;
+			{
+				unique_lock<mutex> lock(mutex_);
+				cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+				if (queue_.empty()) { // stop_ かつ残りなし
+					return;
+				}
+				job = std::move(queue_.front());
+				queue_.pop_front();
+			}
+			if (failed_) {
+				continue;
+			}
+			if (job.is_states) {
+				WriteStatesFile(job);
+			} else {
+				uint32_t n = static_cast<uint32_t>(job.children.size() / 2);
+				if (fwrite(&n, sizeof(n), 1, levels_fp_) != 1
+					|| fwrite(job.children.data(), sizeof(uint32_t), job.children.size(), levels_fp_)
+						!= job.children.size()) {
+					Fail(directory_ + "/levels.bin");
+				}
+			}
+		}
+	}
+
+	// levels.bin をディスクに書き出してから，states.bin を一時ファイル経由で置き換える
+	void WriteStatesFile(const Job& job)
+	{
+		if (fflush(levels_fp_) != 0 || fsync(fileno(levels_fp_)) != 0) {
+			Fail(directory_ + "/levels.bin");
+			return;
+		}
+		int64_t levels_length = ftell(levels_fp_);
+		string path = directory_ + "/states.bin";
+		string tmp_path = path + ".tmp";
+		FILE* fp = fopen(tmp_path.c_str(), "wb");
+		int32_t header[2] = { job.level, job.number_of_states };
+		bool ok = fp != NULL && fwrite(kStatesMagic, 1, 8, fp) == 8
+			&& fwrite(&fingerprint_, sizeof(fingerprint_), 1, fp) == 1
+			&& fwrite(header, sizeof(int32_t), 2, fp) == 2
+			&& fwrite(&levels_length, sizeof(levels_length), 1, fp) == 1
+			&& fwrite(job.states.data(), 1, job.states.size(), fp) == job.states.size()
+			&& fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+		if (fp != NULL && fclose(fp) != 0) {
+			ok = false;
+		}
+		if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+			Fail(path);
+		}
+	}
+
+	bool Fail(const string& path)
+	{
+		cerr << "checkpoint: cannot write " << path << ": " << strerror(errno) << endl;
+		failed_ = true;
+		return false;
+	}
+};
+
+//******************************************************************************
+// 複数プロセスによる構築（ConstructOptions::num_processes > 1）
+// コーディネータ（呼び出したプロセス）が num_processes 個のワーカーを fork する。
+// 状態はハッシュ値によってワーカー（シャード）に振り分けられ，各ワーカーは
+// 自分のシャードの状態表だけを持つ。コーディネータは ZDD のノードだけを持つ。
+// レベル i の処理は次の3段階で，段階の間でコーディネータが全員を待ち合わせる。
+//   kShardRoute  : 各ワーカーが自分の状態の子を計算し，子の状態を持ち主のシャードごとの
+//                  ファイルに書き出す。
+//   kShardMerge  : 各ワーカーが自分宛ての子の状態を次のレベルの状態表に加え，
+//                  送り主ごとに状態の番号をファイルで返す。次のレベルの状態の数を報告する。
+//   kShardResolve: 各ワーカーが返ってきた番号で子を確定し，子の番号（シャードと
+//                  シャード内の番号）をファイルに書き出す。コーディネータがそれを読んで
+//                  ノードの子を設定する。
+// 待ち合わせはワーカーごとの UNIX ドメインソケット（socketpair。相手が終了していても
+// SIGPIPE を受けないように send(MSG_NOSIGNAL) で書く）で，状態のやりとりは
+// 一時ディレクトリ（既定は共有メモリ上の /dev/shm）のファイルで行う。レベル i + 1 のノードはシャードの順，シャード内では
+// 状態の番号の順に並ぶ。
+
+enum ShardCommand {
+	kShardRoute = 0,
+	kShardMerge = 1,
+	kShardResolve = 2,
+	kShardQuit = 3
+};
+
+// コーディネータとワーカーの間でやりとりするメッセージ
+struct ShardMessage {
+	int32_t command; // ShardCommand（ワーカーからの返事では使わない）
+	int32_t level;
+	int64_t value;   // ワーカーからの返事：状態の数など。負なら失敗
+};
+
+static bool ReadMessage(int fd, ShardMessage* message)
+{
+	char* p = reinterpret_cast<char*>(message);
+	size_t done = 0;
+	while (done < sizeof(ShardMessage)) {
+		ssize_t r = read(fd, p + done, sizeof(ShardMessage) - done);
+		if (r < 0 && errno == EINTR) {
+			continue;
+		}
+		if (r <= 0) {
+			return false;
+		}
+		done += r;
+	}
+	return true;
+}
+
+static bool WriteMessage(int fd, int command, int level, int64_t value)
+{
+	ShardMessage message;
+	message.command = command;
+	message.level = level;
+	message.value = value;
+	ssize_t r;
+	do {
+		r = send(fd, &message, sizeof(message), MSG_NOSIGNAL);
+	} while (r < 0 && errno == EINTR);
+	return r == static_cast<ssize_t>(sizeof(message));
+}
+
+// 全ワーカーに命令を送る
+static bool BroadcastCommand(const vector<int>& fds, int command, int level)
+{
+	for (size_t k = 0; k < fds.size(); ++k) {
+		if (!WriteMessage(fds[k], command, level, 0)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// 全ワーカーの返事を待ち，値を values に格納する。失敗した（負の値を返した，
+// または終了した）ワーカーがあれば false を返す
+static bool GatherReplies(const vector<int>& fds, vector<int64_t>* values)
+{
+	bool ok = true;
+	for (size_t k = 0; k < fds.size(); ++k) {
+		ShardMessage message;
+		if (!ReadMessage(fds[k], &message) || message.value < 0) {
+			ok = false;
+		} else {
+			(*values)[k] = message.value;
+		}
+	}
+	return ok;
+}
+
+// ファイル path に data（size バイト）を書き出す
+static bool WriteFile(const string& path, const void* data, size_t size)
+{
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (fp == NULL) {
+		return false;
+	}
+	bool ok = (size == 0 || fwrite(data, 1, size, fp) == size);
+	return fclose(fp) == 0 && ok;
+}
+
+// ファイル path の内容を data に読み込んで，ファイルを消す
+template <typename T>
+static bool ReadAndRemoveFile(const string& path, vector<T>* data)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if (fp == NULL) {
+		return false;
+	}
+	bool ok = fseek(fp, 0, SEEK_END) == 0;
+	long size = ftell(fp);
+	ok = ok && size >= 0 && size % sizeof(T) == 0 && fseek(fp, 0, SEEK_SET) == 0;
+	if (ok) {
+		data->resize(size / sizeof(T));
+		ok = data->empty() || fread(data->data(), sizeof(T), data->size(), fp) == data->size();
+	}
+	fclose(fp);
+	remove(path.c_str());
+	return ok;
+}
+
+// ファイル名 <directory>/<prefix><level>_<a>_<b>
+static string ShardFileName(const string& directory, const char* prefix, int level, int a, int b)
+{
+	ostringstream oss;
+	oss << directory << "/" << prefix << level << "_" << a << "_" << b;
+	return oss.str();
+}
+
+// ディレクトリ内のファイルを消してから，ディレクトリを消す
+static void RemoveDirectory(const string& directory)
+{
+	DIR* dir = opendir(directory.c_str());
+	if (dir != NULL) {
+		struct dirent* entry;
+		while ((entry = readdir(dir)) != NULL) {
+			if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+				remove((directory + "/" + entry->d_name).c_str());
+			}
+		}
+		closedir(dir);
+	}
+	rmdir(directory.c_str());
+}
+
+// 状態を持つシャードの番号。状態表のハッシュ（下位ビットを使う）とは別に計算する
+template <typename Cell>
+static int ShardOf(const Cell* state, int width, int num_shards)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (int k = 0; k < width; ++k) {
+		h = (h ^ state[k]) * 0x100000001b3ULL;
+	}
+	return static_cast<int>(MixHash(h) % static_cast<uint64_t>(num_shards));
+}
+
+// メモリ予算の見積もりに用いる，ZDD のノード1つあたりのメモリ
+// （new の管理領域とレベルごとのノードの配列の分を含む）
+static const int64_t kNodeBytes = sizeof(ZDDNode) + 16 + sizeof(ZDDNode*);
+
+// 固定長 record_size バイトのレコードを並べたファイル path を少しずつ読み，
+// レコードごとに func を呼ぶ。読めなければ false を返す
+static bool ForEachRecord(const string& path, size_t record_size,
+	const function<void(const uint8_t*)>& func)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if (fp == NULL) {
+		return false;
+	}
+	vector<uint8_t> buffer(record_size * 4096);
+	size_t n;
+	while ((n = fread(buffer.data(), record_size, 4096, fp)) > 0) {
+		for (size_t k = 0; k < n; ++k) {
+			func(&buffer[k * record_size]);
+		}
+	}
+	bool ok = ferror(fp) == 0;
+	fclose(fp);
+	return ok;
+}
+
+// 状態表 Table を用いた構築の本体。Table::kWidth が 0 でなければ，
+// 状態の長さはその定数になり，ループの回数がコンパイル時に決まる。
+template <typename Table>
+class PackedFrontierAlgorithmImpl {
+private:
+	typedef typename Table::Cell Cell;
+	static const int kWidth = Table::kWidth;
+
+public:
+	static ZDD* Construct(State* state, const vector<PackedLevel>& levels, int max_width,
+		const ConstructOptions& options)
+	{
+		if (options.num_processes > 1) {
+			return ConstructSharded(state, levels, max_width, options);
+		}
+		int m = static_cast<int>(state->graph->GetEdgeList().size());
+		// 状態1つあたりのセル数
+		int width = (kWidth > 0 ? kWidth : max_width);
+
+		ZDD* zdd = new ZDD(m + 2);
+		vector<Cell> work(width), out(width), label(width);
+		// メモリ予算の見積もりは新しく作った状態表の大きさで行うので，予算があれば使い回さない
+		ConstructWorkspace* workspace = (options.memory_budget > 0 ? NULL : options.workspace);
+		Table* current = WorkspaceAccess::Take<Table>(workspace, width);
+		bool added;
+		int first_level = 1; // 構築を始めるレベル
+
+		CheckpointWriter* writer = NULL;
+		if (!options.checkpoint_directory.empty()) {
+			uint64_t fingerprint = ComputeCheckpointFingerprint(state, sizeof(Cell), width);
+			int64_t levels_length = 0;
+			if (options.resume) {
+				CheckpointData data;
+				if (!data.Read(options.checkpoint_directory, fingerprint, sizeof(Cell), width)
+					|| data.number_of_levels >= m) {
+					WorkspaceAccess::Give(workspace, current);
+					delete zdd;
+					return NULL;
+				}
+				Restore(data, width, zdd, current);
+				first_level = data.number_of_levels + 1;
+				levels_length = data.levels_length;
+			}
+			writer = new CheckpointWriter(options.checkpoint_directory, fingerprint);
+			if (!writer->Open(levels_length)) {
+				delete writer;
+				writer = NULL;
+			}
+		}
+		std::chrono::steady_clock::time_point last_checkpoint = std::chrono::steady_clock::now();
+
+		if (first_level == 1) {
+			// 根ノード（F[0] は空なので状態はすべて 0）
+			current->FindOrAdd(out.data(), &added);
+			zdd->AddNode(1, new ZDDNode());
+		}
+
+		ConstructReport report = { kFallbackNone, 0, 0, 0, 0 };
+		int64_t budget = options.memory_budget;
+		double growth = 2.0; // 直前のレベルの状態の数の増加率（次のレベルの見積もりに用いる）
+		// ノードの配列の大きさ（options.profile に記録する）
+		int64_t level_bytes = (options.profile != NULL ? GetLevelArrayBytes(zdd, first_level) : 0);
+		int fallback_level = 0; // 解の個数だけを数える方法に切り替えるレベル
+
+		vector<uint32_t> children; // チェックポイントに書き出す子の番号
+		for (int i = first_level; i <= m; ++i) { // 各辺 i についての処理
+			const PackedLevel& lv = levels[i];
+			// 次のレベルが予算に収まるか見積もる（状態1つあたりの大きさは今のレベルで測る）
+			int64_t usage = zdd->GetNumberOfIds() * kNodeBytes + current->GetMemoryUsage();
+			report.peak_memory = std::max(report.peak_memory, usage);
+			double per_state = static_cast<double>(current->GetMemoryUsage()) / std::max(1, current->GetSize());
+			if (budget > 0 && usage + growth * current->GetSize() * (per_state + kNodeBytes) > budget) {
+				fallback_level = i;
+				break;
+			}
+			Table* next = WorkspaceAccess::Take<Table>(workspace, width);
+			if (writer != NULL) {
+				children.reserve(static_cast<size_t>(current->GetSize()) * 2);
+			}
+
+			bool over = false; // レベルの途中で予算を超えた
+			for (int j = 0; j < current->GetSize() && !over; ++j) { // レベル i の各ノードについての処理
+				ZDDNode* n_hat = zdd->GetNodeList(i)[j];
+				for (int x = 0; x <= 1; ++x) { // x枝（x = 0, 1）についての処理
+					ZDDNode* n_prime;
+					int c = Transition(current->GetState(j), x, lv, i == m, width,
+						work.data(), label.data(), out.data());
+					int index = c;
+					if (c == 0) {
+						n_prime = zdd->GetZeroTerminal();
+					} else if (c == 1) {
+						n_prime = zdd->GetOneTerminal();
+					} else { // x枝の先が0終端でも1終端でもない
+						index = next->FindOrAdd(out.data(), &added);
+						if (added) {
+							zdd->AddNode(i + 1, new ZDDNode());
+							if (budget > 0 && (index & 1023) == 1023) { // 1024 個ごとに確かめる
+								usage = zdd->GetNumberOfIds() * kNodeBytes + current->GetMemoryUsage()
+									+ next->GetMemoryUsage();
+								report.peak_memory = std::max(report.peak_memory, usage);
+								over = usage > budget;
+							}
+						}
+						n_prime = zdd->GetNodeList(i + 1)[index];
+						index += 2;
+					}
+					n_hat->SetChild(n_prime, x);
+					if (writer != NULL) {
+						children.push_back(static_cast<uint32_t>(index));
+					}
+				}
+			}
+			if (over) { // レベル i をやり直す
+				WorkspaceAccess::Give(workspace, next);
+				fallback_level = i;
+				break;
+			}
+			growth = static_cast<double>(next->GetSize()) / std::max(1, current->GetSize());
+			RecordLevelMemory(options.profile, zdd, i,
+				current->GetStateMemoryUsage() + next->GetStateMemoryUsage(),
+				current->GetTableMemoryUsage() + next->GetTableMemoryUsage(), &level_bytes);
+			WorkspaceAccess::Give(workspace, current);
+			current = next;
+
+			if (writer != NULL) { // レベル i が終わったので，チェックポイントに書き出す
+				writer->AppendLevel(&children);
+				std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+				if (i < m && std::chrono::duration<double>(now - last_checkpoint).count()
+					>= options.checkpoint_interval) {
+					vector<uint8_t> states(static_cast<size_t>(current->GetSize()) * width * sizeof(Cell));
+					for (int j = 0; j < current->GetSize(); ++j) {
+						std::memcpy(&states[static_cast<size_t>(j) * width * sizeof(Cell)],
+							current->GetState(j), width * sizeof(Cell));
+					}
+					writer->WriteStates(i, &states, current->GetSize());
+					last_checkpoint = now;
+				}
+			}
+		}
+		delete writer; // 残りの書き出しを待つ
+		if (fallback_level > 0) {
+			// ZDD から根からレベル fallback_level の各ノードへの経路数を求めて，ZDD を捨てる
+			vector<int64_t> counts;
+			int64_t total = TopDownCounts(zdd, fallback_level, &counts);
+			delete zdd;
+			report.fallback = kFallbackCountOnly;
+			report.fallback_level = fallback_level;
+			report.number_of_solutions = CountOnly(state, levels, width, current, &counts,
+				fallback_level, total, growth, options, &report);
+			if (options.report != NULL) {
+				*options.report = report;
+			}
+			return NULL;
+		}
+		WorkspaceAccess::Give(workspace, current);
+		if (options.report != NULL) {
+			*options.report = report;
+		}
+		return zdd;
+	}
+
+	// 状態を深さ優先探索して，s-t パスを cap 本まで数える（PathQuery を参照）。
+	// paths が NULL でなければ見つけたパスを格納する。このときは解のある状態でも
+	// パスを求めるために再び探索する。見つけた本数（cap 以下）を返す。
+	static int64_t Search(State* state, const vector<PackedLevel>& levels, int max_width,
+		int64_t cap, vector<vector<int> >* paths)
+	{
+		int m = static_cast<int>(state->graph->GetEdgeList().size());
+		int width = (kWidth > 0 ? kWidth : max_width);
+		vector<Cell> work(width), out(width), label(width);
+
+		// tables[i] はレベル i で調べた状態，counts[i][j] はその先の解の数（cap で飽和）。
+		// 調べている途中なら -1
+		vector<Table*> tables(m + 2, static_cast<Table*>(NULL));
+		vector<vector<int64_t> > counts(m + 2);
+		bool added;
+		tables[1] = new Table(width);
+		tables[1]->FindOrAdd(out.data(), &added); // 根（状態はすべて 0）
+		counts[1].push_back(-1);
+
+		// stack[i - 1] はレベル i で調べている状態。x は次に調べる枝（1, 0 の順。-1 なら終わり），
+		// count はそこまでに分かったその先の解の数
+		struct Frame {
+			int j;
+			int x;
+			int64_t count;
+		};
+		Frame root = { 0, 1, 0 };
+		vector<Frame> stack(1, root);
+		int64_t found = 0; // 見つけた解の数
+		while (!stack.empty() && found < cap) {
+			int i = static_cast<int>(stack.size());
+			Frame& f = stack.back();
+			if (f.x < 0) { // 両方の枝を調べ終えた
+				int64_t count = f.count;
+				counts[i][f.j] = count;
+				stack.pop_back();
+				if (!stack.empty()) {
+					stack.back().count = std::min(cap, stack.back().count + count);
+				}
+				continue;
+			}
+			int x = f.x--;
+			int c = Transition(tables[i]->GetState(f.j), x, levels[i], i == m, width,
+				work.data(), label.data(), out.data());
+			if (c == 0) {
+				continue;
+			}
+			if (c == 1) {
+				++found;
+				f.count = std::min(cap, f.count + 1);
+				if (paths != NULL) { // 各レベルで調べている枝（x + 1）が 1 の辺がパス
+					paths->push_back(vector<int>());
+					for (size_t d = 0; d < stack.size(); ++d) {
+						if (stack[d].x + 1 == 1) {
+							paths->back().push_back(static_cast<int>(d));
+						}
+					}
+				}
+				continue;
+			}
+			if (tables[i + 1] == NULL) {
+				tables[i + 1] = new Table(width);
+			}
+			int index = tables[i + 1]->FindOrAdd(out.data(), &added);
+			if (added) {
+				counts[i + 1].push_back(-1);
+			} else if (counts[i + 1][index] == 0) { // 解のない状態
+				continue;
+			} else if (paths == NULL) { // 解の数が分かっている状態
+				found = std::min(cap, found + counts[i + 1][index]);
+				f.count = std::min(cap, f.count + counts[i + 1][index]);
+				continue;
+			}
+			Frame frame = { index, 1, 0 };
+			stack.push_back(frame); // f は無効になる
+		}
+		for (size_t i = 0; i < tables.size(); ++i) {
+			delete tables[i];
+		}
+		return std::min(found, cap);
+	}
+
+	// 各レベルのノード数を見積もる（FrontierPlanner を参照）。plan->nodes, plan->paths,
+	// plan->total_nodes, plan->exact を設定する。
+	static void Estimate(State* state, const vector<PackedLevel>& levels, int max_width,
+		int beam_width, int walks, uint64_t seed, FrontierPlan* plan)
+	{
+		int m = static_cast<int>(state->graph->GetEdgeList().size());
+		int width = (kWidth > 0 ? kWidth : max_width);
+		vector<Cell> work(width), out(width), label(width);
+		std::mt19937_64 random(seed);
+		plan->nodes.assign(m + 1, 0.0);
+		plan->paths.assign(m + 1, 0.0);
+		plan->total_nodes = 0.0;
+		plan->exact = true;
+
+		if (beam_width > 0) {
+			// sample は抽出した状態を並べたもの（根から始める）
+			vector<Cell> sample(width, 0);
+			int sample_size = 1;
+			double estimate = 1.0;
+			for (int i = 1; i <= m && sample_size > 0; ++i) {
+				plan->nodes[i] = estimate;
+				plan->total_nodes += estimate;
+				if (i == m) {
+					break;
+				}
+				Table next(width);
+				bool added;
+				int64_t transitions = 0; // 0終端でない枝の数
+				for (int j = 0; j < sample_size; ++j) {
+					for (int x = 0; x <= 1; ++x) {
+						if (Transition(&sample[static_cast<size_t>(j) * width], x, levels[i],
+								false, width, work.data(), label.data(), out.data()) < 0) {
+							next.FindOrAdd(out.data(), &added);
+							++transitions;
+						}
+					}
+				}
+				int size = next.GetSize();
+				estimate = EstimateChildren(sample_size / estimate, transitions, size);
+				vector<int> chosen(size);
+				for (int j = 0; j < size; ++j) {
+					chosen[j] = j;
+				}
+				if (size > beam_width) { // 無作為に beam_width 個を選ぶ
+					for (int j = 0; j < beam_width; ++j) {
+						std::swap(chosen[j], chosen[j + random() % (size - j)]);
+					}
+					chosen.resize(beam_width);
+					plan->exact = false;
+				}
+				sample_size = static_cast<int>(chosen.size());
+				sample.resize(static_cast<size_t>(sample_size) * width);
+				for (int j = 0; j < sample_size; ++j) {
+					std::memcpy(&sample[static_cast<size_t>(j) * width], next.GetState(chosen[j]),
+						sizeof(Cell) * width);
+				}
+			}
+		}
+
+		vector<Cell> current(width), children(2 * width);
+		for (int w = 0; w < walks; ++w) {
+			std::fill(current.begin(), current.end(), 0);
+			double weight = 1.0 / walks;
+			for (int i = 1; i <= m; ++i) {
+				plan->paths[i] += weight;
+				if (i == m) {
+					break;
+				}
+				int branches = 0;
+				for (int x = 0; x <= 1; ++x) {
+					if (Transition(current.data(), x, levels[i], false, width, work.data(),
+							label.data(), &children[branches * width]) < 0) {
+						++branches;
+					}
+				}
+				if (branches == 0) {
+					break;
+				}
+				weight *= branches;
+				int b = static_cast<int>(random() % branches);
+				std::memcpy(current.data(), &children[b * width], sizeof(Cell) * width);
+			}
+		}
+	}
+
+	// レベルの状態を割合 f だけ抽出したとき，0終端でない枝が transitions 本，
+	// 重複を除いた子が distinct 個あったとして，レベル全体の子の数を推定する。
+	// 子がみな d 本の枝から指されるとみなすと，抽出した親から見える子の割合は
+	// 1 - (1 - f)^d なので，distinct / transitions = (1 - (1 - f)^d) / (f d) を d について
+	// 解き（左辺について単調減少），transitions / (f d) を返す。f = 1 なら distinct になる。
+	static double EstimateChildren(double f, int64_t transitions, int64_t distinct)
+	{
+		if (transitions == 0) {
+			return 0.0;
+		}
+		f = std::min(1.0, std::max(f, 1e-300));
+		double target = static_cast<double>(distinct) / transitions;
+		double lo = 1.0, hi = static_cast<double>(transitions);
+		for (int k = 0; k < 100 && target < 1.0; ++k) {
+			double d = (lo + hi) / 2;
+			double visible = (f >= 1.0 ? 1.0 : -std::expm1(d * std::log1p(-f))) / (f * d);
+			if (visible > target) {
+				lo = d;
+			} else {
+				hi = d;
+			}
+		}
+		return transitions / (f * lo);
+	}
+
+	// 逐次モンテカルロ法で解の個数を1回推定する（ApproximateCounter を参照）。
+	// 間引きを一度も行わなかったときは *exact を true にする（推定値は厳密な値になる）
+	static double Approximate(State* state, const vector<PackedLevel>& levels, int max_width,
+		int beam_width, std::mt19937_64* random, bool* exact)
+	{
+		int m = static_cast<int>(state->graph->GetEdgeList().size());
+		int width = (kWidth > 0 ? kWidth : max_width);
+		vector<Cell> work(width), out(width), label(width);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		*exact = true;
+
+		// sample は残した状態を並べたもの，weight はそれぞれの重み（根から始める）
+		vector<Cell> sample(width, 0);
+		vector<double> weight(1, 1.0);
+		double count = 0.0; // 1終端に届いた重みの和
+		for (int i = 1; i <= m && !weight.empty(); ++i) {
+			Table next(width);
+			vector<double> next_weight; // next の状態番号で引く重み（同じ状態の重みは足す）
+			bool added;
+			for (size_t j = 0; j < weight.size(); ++j) {
+				for (int x = 0; x <= 1; ++x) {
+					int c = Transition(&sample[j * width], x, levels[i], i == m, width,
+						work.data(), label.data(), out.data());
+					if (c == 1) {
+						count += weight[j];
+					} else if (c < 0) {
+						int index = next.FindOrAdd(out.data(), &added);
+						if (added) {
+							next_weight.push_back(0.0);
+						}
+						next_weight[index] += weight[j];
+					}
+				}
+			}
+
+			// 残す状態の番号と重み。beam_width 個を超えたら，重みの和を beam_width 等分した
+			// 間隔 step の櫛（開始位置は [0, step) から一様に選ぶ）で系統抽出する。
+			// 状態は櫛の歯が当たった回数 c だけ選ばれ，重みは c * step になる（期待値は元の重み）
+			int size = next.GetSize();
+			vector<int> chosen;
+			weight.clear();
+			if (size <= beam_width) {
+				for (int j = 0; j < size; ++j) {
+					chosen.push_back(j);
+				}
+				weight.swap(next_weight);
+			} else {
+				*exact = false;
+				double total = 0.0;
+				for (int j = 0; j < size; ++j) {
+					total += next_weight[j];
+				}
+				double step = total / beam_width;
+				double point = uniform(*random) * step; // 次の櫛の歯の位置
+				double cumulative = 0.0;
+				int teeth = 0; // 当たった歯の数
+				for (int j = 0; j < size && teeth < beam_width; ++j) {
+					cumulative += next_weight[j];
+					int c = 0;
+					while (point < cumulative && teeth < beam_width) {
+						++c;
+						++teeth;
+						point += step;
+					}
+					if (c > 0) {
+						chosen.push_back(j);
+						weight.push_back(c * step);
+					}
+				}
+			}
+			sample.resize(chosen.size() * width);
+			for (size_t j = 0; j < chosen.size(); ++j) {
+				std::memcpy(&sample[j * width], next.GetState(chosen[j]), sizeof(Cell) * width);
+			}
+		}
+		return count;
+	}
+
+	// num_processes 個のワーカープロセスで構築する（上の「複数プロセスによる構築」を参照）
+	static ZDD* ConstructSharded(State* state, const vector<PackedLevel>& levels, int max_width,
+		const ConstructOptions& options)
+	{
+		int m = static_cast<int>(state->graph->GetEdgeList().size());
+		int width = (kWidth > 0 ? kWidth : max_width);
+		int n = options.num_processes;
+
+		string pattern = options.shard_directory + "/frontier-XXXXXX";
+		vector<char> buffer(pattern.begin(), pattern.end());
+		buffer.push_back('\0');
+		if (mkdtemp(buffer.data()) == NULL) {
+			return NULL;
+		}
+		string directory = buffer.data();
+
+		vector<int> fds;
+		vector<pid_t> pids;
+		bool ok = true;
+		for (int k = 0; k < n; ++k) {
+			int sv[2];
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+				ok = false;
+				break;
+			}
+			pid_t pid = fork();
+			if (pid == 0) { // ワーカー。他のワーカーへのソケットは閉じる
+				for (size_t q = 0; q < fds.size(); ++q) {
+					close(fds[q]);
+				}
+				close(sv[0]);
+				RunShardWorker(state, levels, width, k, n, directory, sv[1]);
+				_exit(0); // 親から受け継いだ出力バッファなどは後始末しない
+			}
+			close(sv[1]);
+			if (pid < 0) {
+				close(sv[0]);
+				ok = false;
+				break;
+			}
+			fds.push_back(sv[0]);
+			pids.push_back(pid);
+		}
+
+		ZDD* zdd = new ZDD(m + 2);
+		// 各シャードのレベル i のノード数と，レベル i 内での先頭位置
+		vector<int64_t> counts(n), offsets;
+		ok = ok && GatherReplies(fds, &counts); // 根を持つシャードだけが 1 を返す
+		if (ok) {
+			AddShardedNodes(zdd, 1, counts, &offsets);
+		}
+		for (int i = 1; ok && i <= m; ++i) {
+			vector<int64_t> next_counts(n), next_offsets, unused(n);
+			ok = BroadcastCommand(fds, kShardRoute, i) && GatherReplies(fds, &unused)
+				&& BroadcastCommand(fds, kShardMerge, i) && GatherReplies(fds, &next_counts);
+			if (ok) {
+				AddShardedNodes(zdd, i + 1, next_counts, &next_offsets);
+				ok = BroadcastCommand(fds, kShardResolve, i) && GatherReplies(fds, &unused);
+			}
+			for (int k = 0; ok && k < n; ++k) { // シャード k のノードの子を設定する
+				vector<uint64_t> codes;
+				ok = ReadAndRemoveFile(ShardFileName(directory, "c", i, k, 0), &codes)
+					&& static_cast<int64_t>(codes.size()) == 2 * counts[k];
+				for (size_t p = 0; ok && p < codes.size(); ++p) {
+					ZDDNode* child;
+					if (codes[p] <= 1) {
+						child = (codes[p] == 0 ? zdd->GetZeroTerminal() : zdd->GetOneTerminal());
+					} else {
+						int r = static_cast<int>(codes[p] >> 32) - 1;
+						int64_t index = static_cast<int64_t>(codes[p] & 0xffffffffULL);
+						if (r < 0 || r >= n || index >= next_counts[r]) {
+							ok = false;
+							break;
+						}
+						child = zdd->GetNodeList(i + 1)[next_offsets[r] + index];
+					}
+					zdd->GetNodeList(i)[offsets[k] + p / 2]->SetChild(child, static_cast<int>(p % 2));
+				}
+			}
+			counts.swap(next_counts);
+			offsets.swap(next_offsets);
+		}
+
+		// ワーカーを終わらせる。失敗したときは待たずに止める
+		for (size_t k = 0; k < fds.size(); ++k) {
+			if (ok) {
+				WriteMessage(fds[k], kShardQuit, 0, 0);
+			} else {
+				kill(pids[k], SIGKILL);
+			}
+			close(fds[k]);
+		}
+		for (size_t k = 0; k < pids.size(); ++k) {
+			int status;
+			while (waitpid(pids[k], &status, 0) < 0 && errno == EINTR) {
+			}
+		}
+		RemoveDirectory(directory);
+		if (!ok) {
+			delete zdd;
+			return NULL;
+		}
+		return zdd;
+	}
+
+private:
+	// ZDD の根からレベル level の各ノードへの経路の数を counts に格納し，
+	// レベル level より上から1終端に至る経路の数を返す
+	static int64_t TopDownCounts(ZDD* zdd, int level, vector<int64_t>* counts)
+	{
+		vector<int64_t> paths(zdd->GetNumberOfIds(), 0); // ノードIDごとの経路の数
+		paths[zdd->GetNodeList(1)[0]->GetId()] = 1;
+		int64_t total = 0;
+		for (int i = 1; i < level; ++i) {
+			const vector<ZDDNode*>& N_i = zdd->GetNodeList(i);
+			for (size_t j = 0; j < N_i.size(); ++j) {
+				for (int x = 0; x <= 1; ++x) {
+					ZDDNode* child = N_i[j]->GetChild(x);
+					if (child == zdd->GetOneTerminal()) {
+						total += paths[N_i[j]->GetId()];
+					} else if (child != zdd->GetZeroTerminal()) {
+						paths[child->GetId()] += paths[N_i[j]->GetId()];
+					}
+				}
+			}
+		}
+		const vector<ZDDNode*>& N_level = zdd->GetNodeList(level);
+		counts->resize(N_level.size());
+		for (size_t j = 0; j < N_level.size(); ++j) {
+			(*counts)[j] = paths[N_level[j]->GetId()];
+		}
+		return total;
+	}
+
+	// ZDD を作らずに，根から各状態への経路の数を上から伝えて解の個数を数える。
+	// レベル first_level の状態 current（解放する）と経路の数 counts から始め，
+	// total（それより上で1終端に至った経路の数）に足して返す。
+	// 次のレベルが予算に収まらなければ CountSpilled に切り替える。
+	static int64_t CountOnly(State* state, const vector<PackedLevel>& levels, int width,
+		Table* current, vector<int64_t>* counts, int first_level, int64_t total, double growth,
+		const ConstructOptions& options, ConstructReport* report)
+	{
+		int m = static_cast<int>(state->graph->GetEdgeList().size());
+		int64_t budget = options.memory_budget;
+		vector<Cell> work(width), out(width), label(width);
+		bool added;
+
+		for (int i = first_level; i <= m; ++i) {
+			int64_t usage = current->GetMemoryUsage() + counts->capacity() * sizeof(int64_t);
+			report->peak_memory = std::max(report->peak_memory, usage);
+			double per_state = static_cast<double>(usage) / std::max(1, current->GetSize());
+			bool over = budget > 0 && usage + growth * current->GetSize() * per_state > budget;
+
+			Table* next = over ? NULL : new Table(width);
+			vector<int64_t> next_counts;
+			int64_t level_total = 0; // このレベルで1終端に至った経路の数
+			for (int j = 0; j < current->GetSize() && !over; ++j) {
+				for (int x = 0; x <= 1; ++x) {
+					int c = Transition(current->GetState(j), x, levels[i], i == m, width,
+						work.data(), label.data(), out.data());
+					if (c == 1) {
+						level_total += (*counts)[j];
+					} else if (c < 0) {
+						int index = next->FindOrAdd(out.data(), &added);
+						if (added) {
+							next_counts.push_back(0);
+							if (budget > 0 && (index & 1023) == 1023) {
+								int64_t next_usage = usage + next->GetMemoryUsage()
+									+ next_counts.capacity() * sizeof(int64_t);
+								report->peak_memory = std::max(report->peak_memory, next_usage);
+								over = next_usage > budget;
+							}
+						}
+						next_counts[index] += (*counts)[j];
+					}
+				}
+			}
+			if (over) { // レベル i から状態をディスクに書き出す方法でやり直す
+				delete next;
+				return CountSpilled(state, levels, width, current, counts, i, total, growth,
+					options, report);
+			}
+			total += level_total;
+			growth = static_cast<double>(next->GetSize()) / std::max(1, current->GetSize());
+			delete current;
+			current = next;
+			counts->swap(next_counts);
+		}
+		delete current;
+		return total;
+	}
+
+	// 状態をハッシュ値で区画に分けてファイルに書き出しながら，解の個数を数える。
+	// 区画のファイルには状態と経路の数（int64_t）の組を並べる。各レベルで，
+	// 今のレベルの区画を順に読んで子の状態を次のレベルの区画に書き出し，
+	// 次のレベルの区画を1つずつ読み込んで重複除去する。区画の数は，1つの区画の
+	// 状態表が予算の半分に収まるように見積もって決める。
+	// 引数は CountOnly と同じ。ファイルの読み書きに失敗したら -1 を返す。
+	static int64_t CountSpilled(State* state, const vector<PackedLevel>& levels, int width,
+		Table* current, vector<int64_t>* counts, int first_level, int64_t total, double growth,
+		const ConstructOptions& options, ConstructReport* report)
+	{
+		int m = static_cast<int>(state->graph->GetEdgeList().size());
+		report->fallback = kFallbackSpill;
+		report->spill_level = first_level;
+
+		string pattern = options.spill_directory + "/frontier-spill-XXXXXX";
+		vector<char> buffer(pattern.begin(), pattern.end());
+		buffer.push_back('\0');
+		if (mkdtemp(buffer.data()) == NULL) {
+			delete current;
+			return -1;
+		}
+		string directory = buffer.data();
+
+		// レベル first_level の状態を1つの区画に書き出す
+		size_t state_size = width * sizeof(Cell);
+		size_t record_size = state_size + sizeof(int64_t);
+		vector<uint8_t> record(record_size);
+		int64_t current_states = current->GetSize();
+		double per_state = static_cast<double>(current->GetMemoryUsage()
+			+ counts->capacity() * sizeof(int64_t)) / std::max<int64_t>(1, current_states);
+		FILE* fp = fopen(ShardFileName(directory, "L", first_level, 0, 0).c_str(), "wb");
+		bool ok = fp != NULL;
+		for (int j = 0; ok && j < current->GetSize(); ++j) {
+			std::memcpy(record.data(), current->GetState(j), state_size);
+			std::memcpy(record.data() + state_size, &(*counts)[j], sizeof(int64_t));
+			ok = fwrite(record.data(), record_size, 1, fp) == 1;
+		}
+		ok = (fp != NULL && fclose(fp) == 0) && ok;
+		delete current;
+		vector<int64_t>().swap(*counts);
+
+		vector<Cell> in(width), work(width), out(width), label(width);
+		bool added;
+		int parts = 1;
+		for (int i = first_level; ok && i <= m; ++i) {
+			// 次のレベルの区画の数を決めて，区画のファイルを開く。
+			// 状態の少ない区画をいくつも作らないように，区画あたり 256 状態以上にする
+			double estimate = growth * current_states;
+			double max_parts = std::max(1.0, std::min(4096.0, estimate / 256));
+			int next_parts = static_cast<int>(std::min(max_parts,
+				std::max(1.0, std::ceil(2.0 * estimate * per_state / options.memory_budget))));
+			vector<FILE*> outs(i < m ? next_parts : 0, static_cast<FILE*>(NULL));
+			for (size_t p = 0; p < outs.size(); ++p) {
+				outs[p] = fopen(ShardFileName(directory, "N", i + 1, static_cast<int>(p), 0).c_str(), "wb");
+				ok = ok && outs[p] != NULL;
+			}
+
+			// 今のレベルの区画を順に読み，子の状態を次のレベルの区画に書き出す
+			int64_t level_total = 0;
+			for (int q = 0; ok && q < parts; ++q) {
+				string path = ShardFileName(directory, "L", i, q, 0);
+				ok = ForEachRecord(path, record_size, [&](const uint8_t* r) {
+					int64_t count;
+					std::memcpy(in.data(), r, state_size);
+					std::memcpy(&count, r + state_size, sizeof(int64_t));
+					for (int x = 0; x <= 1; ++x) {
+						int c = Transition(in.data(), x, levels[i], i == m, width,
+							work.data(), label.data(), out.data());
+						if (c == 1) {
+							level_total += count;
+						} else if (c < 0) {
+							FILE* dest = outs[ShardOf(out.data(), width, next_parts)];
+							if (fwrite(out.data(), state_size, 1, dest) != 1
+								|| fwrite(&count, sizeof(int64_t), 1, dest) != 1) {
+								ok = false;
+							}
+						}
+					}
+				}) && ok;
+				remove(path.c_str());
+			}
+			for (size_t p = 0; p < outs.size(); ++p) {
+				if (outs[p] != NULL && fclose(outs[p]) != 0) {
+					ok = false;
+				}
+			}
+			total += level_total;
+			if (i == m || !ok) {
+				break;
+			}
+
+			// 次のレベルの区画を1つずつ重複除去する
+			int64_t next_states = 0;
+			int64_t next_memory = 0;
+			for (int p = 0; ok && p < next_parts; ++p) {
+				string path = ShardFileName(directory, "N", i + 1, p, 0);
+				Table table(width);
+				vector<int64_t> part_counts;
+				ok = ForEachRecord(path, record_size, [&](const uint8_t* r) {
+					int64_t count;
+					std::memcpy(in.data(), r, state_size);
+					std::memcpy(&count, r + state_size, sizeof(int64_t));
+					int index = table.FindOrAdd(in.data(), &added);
+					if (added) {
+						part_counts.push_back(0);
+					}
+					part_counts[index] += count;
+				});
+				remove(path.c_str());
+				int64_t usage = table.GetMemoryUsage() + part_counts.capacity() * sizeof(int64_t);
+				report->peak_memory = std::max(report->peak_memory, usage);
+				next_memory += usage;
+				next_states += table.GetSize();
+
+				fp = fopen(ShardFileName(directory, "L", i + 1, p, 0).c_str(), "wb");
+				ok = ok && fp != NULL;
+				for (int j = 0; ok && j < table.GetSize(); ++j) {
+					std::memcpy(record.data(), table.GetState(j), state_size);
+					std::memcpy(record.data() + state_size, &part_counts[j], sizeof(int64_t));
+					ok = fwrite(record.data(), record_size, 1, fp) == 1;
+				}
+				ok = (fp != NULL && fclose(fp) == 0) && ok;
+			}
+			if (next_states == 0) { // これ以上の状態はない
+				break;
+			}
+			growth = static_cast<double>(next_states) / std::max<int64_t>(1, current_states);
+			per_state = static_cast<double>(next_memory) / next_states;
+			current_states = next_states;
+			parts = next_parts;
+		}
+		RemoveDirectory(directory);
+		return ok ? total : -1;
+	}
+
+	// レベル level のノードを，シャードの順に counts[k] 個ずつ作る。
+	// offsets[k] にはシャード k の先頭位置を格納する
+	static void AddShardedNodes(ZDD* zdd, int level, const vector<int64_t>& counts,
+		vector<int64_t>* offsets)
+	{
+		offsets->assign(counts.size(), 0);
+		int64_t total = 0;
+		for (size_t k = 0; k < counts.size(); ++k) {
+			(*offsets)[k] = total;
+			for (int64_t j = 0; j < counts[k]; ++j) {
+				zdd->AddNode(level, new ZDDNode());
+			}
+			total += counts[k];
+		}
+	}
+
+	// シャード shard を受け持つワーカーの処理。コーディネータからの命令を fd から読み，
+	// 返事を fd に書く。最初に（根を持っていれば 1 の）状態の数を返す。
+	static void RunShardWorker(State* state, const vector<PackedLevel>& levels, int width,
+		int shard, int num_shards, const string& directory, int fd)
+	{
+		int m = static_cast<int>(state->graph->GetEdgeList().size());
+		vector<Cell> work(width), out(width), label(width);
+		Table* current = new Table(width);
+		Table* next = NULL;
+		bool added;
+
+		// 根ノード（状態はすべて 0）は持ち主のシャードだけが持つ
+		if (ShardOf(out.data(), width, num_shards) == shard) {
+			current->FindOrAdd(out.data(), &added);
+		}
+		// 自分のノードの子。0終端は 0，1終端は 1，それ以外は (シャード + 1) << 32 | 番号
+		// （kShardRoute の後は，送り先のファイル内での順番）
+		vector<uint64_t> codes;
+		vector<vector<Cell> > routed(num_shards); // 送り先のシャードごとの子の状態
+
+		bool ok = WriteMessage(fd, 0, 0, current->GetSize());
+		ShardMessage message;
+		while (ok && ReadMessage(fd, &message) && message.command != kShardQuit) {
+			int i = message.level;
+			int64_t value = 0;
+			if (message.command == kShardRoute) {
+				const PackedLevel& lv = levels[i];
+				codes.clear();
+				for (int r = 0; r < num_shards; ++r) {
+					routed[r].clear();
+				}
+				for (int j = 0; j < current->GetSize(); ++j) {
+					for (int x = 0; x <= 1; ++x) {
+						int c = Transition(current->GetState(j), x, lv, i == m, width,
+							work.data(), label.data(), out.data());
+						if (c == 0 || c == 1) {
+							codes.push_back(c);
+						} else {
+							int r = ShardOf(out.data(), width, num_shards);
+							codes.push_back(static_cast<uint64_t>(r + 1) << 32 | (routed[r].size() / width));
+							routed[r].insert(routed[r].end(), out.begin(), out.end());
+						}
+					}
+				}
+				for (int r = 0; r < num_shards; ++r) {
+					if (!WriteFile(ShardFileName(directory, "s", i, shard, r),
+							routed[r].data(), routed[r].size() * sizeof(Cell))) {
+						value = -1;
+					}
+				}
+			} else if (message.command == kShardMerge) {
+				next = new Table(width);
+				vector<Cell> incoming;
+				vector<uint32_t> indices;
+				for (int k = 0; k < num_shards && value == 0; ++k) { // 送り主の順に加える
+					if (!ReadAndRemoveFile(ShardFileName(directory, "s", i, k, shard), &incoming)) {
+						value = -1;
+						break;
+					}
+					indices.clear();
+					for (size_t p = 0; p < incoming.size(); p += width) {
+						indices.push_back(static_cast<uint32_t>(next->FindOrAdd(&incoming[p], &added)));
+					}
+					if (!WriteFile(ShardFileName(directory, "r", i, shard, k),
+							indices.data(), indices.size() * sizeof(uint32_t))) {
+						value = -1;
+					}
+				}
+				if (value == 0) {
+					value = next->GetSize();
+				}
+			} else if (message.command == kShardResolve) {
+				vector<vector<uint32_t> > indices(num_shards);
+				for (int r = 0; r < num_shards && value == 0; ++r) {
+					if (!ReadAndRemoveFile(ShardFileName(directory, "r", i, r, shard), &indices[r])) {
+						value = -1;
+					}
+				}
+				for (size_t p = 0; p < codes.size() && value == 0; ++p) {
+					if (codes[p] > 1) {
+						int r = static_cast<int>(codes[p] >> 32) - 1;
+						codes[p] = static_cast<uint64_t>(r + 1) << 32 | indices[r][codes[p] & 0xffffffffULL];
+					}
+				}
+				if (value == 0 && !WriteFile(ShardFileName(directory, "c", i, shard, 0),
+						codes.data(), codes.size() * sizeof(uint64_t))) {
+					value = -1;
+				}
+				delete current;
+				current = next;
+				next = NULL;
+			}
+			ok = WriteMessage(fd, message.command, i, value);
+		}
+		delete current;
+		delete next;
+	}
+
+	// チェックポイントの内容から，レベル 1 から L + 1 のノードとレベル L + 1 の状態表を復元する
+	static void Restore(const CheckpointData& data, int width, ZDD* zdd, Table* current)
+	{
+		int L = data.number_of_levels;
+		// ノードIDがレベル順になるように，先にすべてのノードを作る
+		for (int i = 1; i <= L; ++i) {
+			for (size_t j = 0; j < data.children[i - 1].size() / 2; ++j) {
+				zdd->AddNode(i, new ZDDNode());
+			}
+		}
+		vector<Cell> state(width);
+		for (int j = 0; j < data.number_of_states; ++j) {
+			bool added;
+			std::memcpy(state.data(), &data.states[static_cast<size_t>(j) * width * sizeof(Cell)],
+				width * sizeof(Cell));
+			current->FindOrAdd(state.data(), &added);
+			zdd->AddNode(L + 1, new ZDDNode());
+		}
+		for (int i = 1; i <= L; ++i) {
+			const vector<ZDDNode*>& N_i = zdd->GetNodeList(i);
+			for (size_t j = 0; j < N_i.size(); ++j) {
+				for (int x = 0; x <= 1; ++x) {
+					uint32_t index = data.children[i - 1][2 * j + x];
+					N_i[j]->SetChild(index == 0 ? zdd->GetZeroTerminal()
+						: (index == 1 ? zdd->GetOneTerminal() : zdd->GetNodeList(i + 1)[index - 2]), x);
+				}
+			}
+		}
+	}
+
+	static int Deg(Cell cell)
+	{
+		return cell & 3;
+	}
+
+	static int Comp(Cell cell)
+	{
+		return cell >> 2;
+	}
+
+	static Cell MakeCell(int deg, int comp)
+	{
+		return static_cast<Cell>(deg | (comp << 2));
+	}
+
+	// 状態 in のノードの x枝の先を計算する（CheckTerminal と UpdateInfo をまとめたもの）。
+	// 0終端なら 0，1終端なら 1 を返す。どちらでもなければ，子ノードの状態を out に
+	// 格納して -1 を返す。work, label は作業用配列。
+	static int Transition(const Cell* in, int x, const PackedLevel& lv, bool is_last_edge,
+		int width, Cell* work, Cell* label, Cell* out)
+	{
+		if (lv.infeasible || (lv.fixed_value >= 0 && x != lv.fixed_value)) {
+			return 0;
+		}
+		// 作業用配列を作る。新たに入る頂点は deg = 0, comp = 自分の位置（端点のラベル）
+		std::memcpy(work, in, sizeof(Cell) * (kWidth > 0 ? kWidth : lv.prev_width));
+		for (int k = lv.prev_width; k < lv.work_width; ++k) {
+			work[k] = MakeCell(0, lv.entering_comp[k - lv.prev_width]);
+		}
+
+		if (x == 1) {
+			int c_src = Comp(work[lv.src_pos]);
+			int c_dest = Comp(work[lv.dest_pos]);
+			if (c_src == c_dest || !lv.usable) { // サイクルが生じる
+				return 0;
+			}
+			int c_to = std::min(c_src, c_dest), c_from = std::max(c_src, c_dest);
+			if (lv.label_base >= 0 && c_from >= lv.label_base) {
+				if (c_to >= lv.label_base) { // 異なる組の端点を含む成分はつながない
+					if ((c_to - lv.label_base) / 2 != (c_from - lv.label_base) / 2) {
+						return 0;
+					}
+				} else { // 端点を含む成分に，含まない成分をつなぐ
+					std::swap(c_to, c_from);
+				}
+			}
+			int d_src = Deg(work[lv.src_pos]);
+			int d_dest = Deg(work[lv.dest_pos]);
+			if (lv.directed) {
+				// src の出次数，dest の入次数が1を超える（s, t の向きは usable で調べてある）
+				if ((d_src & 2) != 0 || (d_dest & 1) != 0) {
+					return 0;
+				}
+				d_src |= 2;
+				d_dest |= 1;
+			} else {
+				++d_src;
+				++d_dest;
+				// 始点，終点の次数が1を超える，またはそれ以外の次数が2を超える
+				if (d_src > (lv.src_is_terminal ? 1 : 2) || d_dest > (lv.dest_is_terminal ? 1 : 2)) {
+					return 0;
+				}
+			}
+			work[lv.src_pos] = MakeCell(d_src, c_src);
+			work[lv.dest_pos] = MakeCell(d_dest, c_dest);
+
+			// c_from -> c_to にする（使っていない位置のセルが変わっても，out には写さない）
+			Table::Relabel(work, lv.work_width, c_from, c_to);
+		}
+
+		for (size_t k = 0; k < lv.leaving_pos.size(); ++k) { // フロンティアから去る頂点のチェック
+			int d = Deg(work[lv.leaving_pos[k]]);
+			if (lv.directed) { // s は出次数，t は入次数が1。それ以外は入次数 = 出次数
+				if (lv.leaving_is_terminal[k] ? d == 0 : (d != 0 && d != 3)) {
+					return 0;
+				}
+			} else if (lv.leaving_is_terminal[k] ? d != 1 : (d != 0 && d != 2)) {
+				return 0;
+			}
+		}
+		if (is_last_edge) {
+			return 1;
+		}
+
+		// F[i] 上の状態を作る。comp は成分内で最も前の位置に付け替える（正規化）
+		std::memset(label, 0xff, sizeof(Cell) * width);
+		if (kWidth > 0) {
+			std::memset(out, 0, sizeof(Cell) * kWidth);
+		}
+		if (lv.label_base >= 0) { // 端点のラベルはそのまま
+			for (size_t p = 0; p < lv.next_from.size(); ++p) {
+				Cell cell = work[lv.next_from[p]];
+				int c = Comp(cell);
+				if (c < lv.label_base && label[c] == static_cast<Cell>(-1)) {
+					label[c] = static_cast<Cell>(p);
+				}
+				out[p] = (c < lv.label_base ? MakeCell(Deg(cell), label[c]) : cell);
+			}
+			return -1;
+		}
+		for (size_t p = 0; p < lv.next_from.size(); ++p) {
+			Cell cell = work[lv.next_from[p]];
+			int c = Comp(cell);
+			if (label[c] == static_cast<Cell>(-1)) {
+				label[c] = static_cast<Cell>(p);
+			}
+			out[p] = MakeCell(Deg(cell), label[c]);
+		}
+		return -1;
+	}
+};
+
+// 幅 W を固定した実装で action を実行する。simd に応じてカーネルを選ぶ。
+template <int W, typename Action>
+static typename Action::Result DispatchFixedWidth(State* state, const vector<PackedLevel>& levels,
+	int max_width, SimdLevel simd, const Action& action)
+{
+#if FRONTIER_X86_SIMD
+	// AVX2 はカーネル単体で SSE2 より速い W = 64 だけで用いる（W = 32 では差がないか遅い）
+	if (simd >= kSimdAvx2 && W >= 64) {
+		return action.template Run<FixedWidthStateTable<W, Avx2Kernels<W> > >(state, levels,
+			max_width);
+	} else if (simd >= kSimdSse2) {
+		return action.template Run<FixedWidthStateTable<W, Sse2Kernels<W> > >(state, levels,
+			max_width);
+	}
+#endif
+	return action.template Run<FixedWidthStateTable<W, ScalarKernels<W> > >(state, levels,
+		max_width);
+}
+
+// フロンティアの大きさの最大値に応じて状態表を選び，
+// action.Run<Table>(state, levels, max_width) を呼ぶ。
+// 端点のラベルが uint8_t のセルの comp（6 ビット）に収まらなければ，幅を実行時に決める版を用いる。
+template <typename Action>
+static typename Action::Result DispatchPacked(State* state, SimdLevel simd, const Action& action)
+{
+	vector<PackedLevel> levels;
+	PackedLevel::Compute(state, &levels);
+
+	int max_width = 1;
+	for (size_t i = 1; i < levels.size(); ++i) {
+		max_width = std::max(max_width, levels[i].work_width);
+	}
+
+	if (PackedLevel::GetCompLimit(levels, max_width) > 64) {
+		return action.template Run<DynamicWidthStateTable>(state, levels, max_width);
+	} else if (max_width <= 16) {
+		return DispatchFixedWidth<16>(state, levels, max_width, simd, action);
+	} else if (max_width <= 32) {
+		return DispatchFixedWidth<32>(state, levels, max_width, simd, action);
+	} else if (max_width <= 64) {
+		return DispatchFixedWidth<64>(state, levels, max_width, simd, action);
+	} else {
+		return action.template Run<DynamicWidthStateTable>(state, levels, max_width);
+	}
+}
+
+struct ConstructAction {
+	typedef ZDD* Result;
+	const ConstructOptions& options;
+
+	template <typename Table>
+	Result Run(State* state, const vector<PackedLevel>& levels, int max_width) const
+	{
+		return PackedFrontierAlgorithmImpl<Table>::Construct(state, levels, max_width, options);
+	}
+};
+
+struct SearchAction {
+	typedef int64_t Result;
+	int64_t cap;
+	vector<vector<int> >* paths;
+
+	template <typename Table>
+	Result Run(State* state, const vector<PackedLevel>& levels, int max_width) const
+	{
+		return PackedFrontierAlgorithmImpl<Table>::Search(state, levels, max_width, cap, paths);
+	}
+};
+
+struct EstimateAction {
+	typedef bool Result;
+	int beam_width;
+	int walks;
+	uint64_t seed;
+	FrontierPlan* plan;
+
+	template <typename Table>
+	Result Run(State* state, const vector<PackedLevel>& levels, int max_width) const
+	{
+		PackedFrontierAlgorithmImpl<Table>::Estimate(state, levels, max_width, beam_width, walks,
+			seed, plan);
+		return true;
+	}
+};
+
+struct ApproximateAction {
+	typedef bool Result;
+	int beam_width;
+	int replicates;
+	uint64_t seed;
+	vector<double>* estimates; // 反復ごとの推定値
+	bool* exact;
+
+	template <typename Table>
+	Result Run(State* state, const vector<PackedLevel>& levels, int max_width) const
+	{
+		std::mt19937_64 random(seed);
+		for (int r = 0; r < replicates; ++r) {
+			estimates->push_back(PackedFrontierAlgorithmImpl<Table>::Approximate(state, levels,
+				max_width, beam_width, &random, exact));
+			if (*exact) { // 間引きが起きなければ何度繰り返しても同じ
+				break;
+			}
+		}
+		return true;
+	}
+};
+
+// 詰めた状態表現で探索する。カーネルは実行中の CPU に合わせて選ぶ。
+static int64_t SearchPacked(State* state, int64_t cap, vector<vector<int> >* paths)
+{
+	// 辺のない端点があるときは PackedLevel::Compute が解なしとする。辺がなければ探索しない
+	if (state->graph->GetEdgeList().empty()) {
+		return 0;
+	}
+
+	SearchAction action = { cap, paths };
+	return DispatchPacked(state, DetectSimdLevel(), action);
+}
+
+bool PathQuery::Exists(State* state, vector<int>* path)
+{
+	vector<vector<int> > paths;
+	if (SearchPacked(state, 1, &paths) == 0) {
+		return false;
+	}
+	if (path != NULL) {
+		path->swap(paths[0]);
+	}
+	return true;
+}
+
+int64_t PathQuery::CountUpTo(State* state, int64_t cap)
+{
+	return SearchPacked(state, cap, NULL);
+}
+
+int64_t PathQuery::FindPaths(State* state, int64_t k, vector<vector<int> >* paths)
+{
+	paths->clear();
+	return SearchPacked(state, k, paths);
+}
+
+ConstructOptions::ConstructOptions()
+{
+	simd = DetectSimdLevel();
+	checkpoint_interval = 60.0;
+	resume = false;
+	num_processes = 1;
+	shard_directory = "/dev/shm";
+	memory_budget = 0;
+	spill_directory = "/tmp";
+	report = NULL;
+	profile = NULL;
+	workspace = NULL;
+}
+
+// 詰めた状態表現によるフロンティア法の入口。
+// フロンティアの大きさの最大値に応じて，幅を固定した実装に振り分ける。
+ZDD* PackedFrontierAlgorithm::Construct(State* state, const ConstructOptions& options)
+{
+	ConstructAction action = { options };
+	return DispatchPacked(state, options.simd, action);
+}
+
+//******************************************************************************
+// 辺の順序の見積もり
+
+void FrontierPlanner::Estimate(State* state, int beam_width, int walks, uint64_t seed,
+	FrontierPlan* plan)
+{
+	int m = static_cast<int>(state->graph->GetEdgeList().size());
+	plan->number_of_levels = m;
+	plan->width.resize(m + 1);
+	plan->max_width = 0;
+	double sum = 0.0;
+	for (int i = 0; i <= m; ++i) {
+		plan->width[i] = static_cast<int>(state->F[i]->size());
+		plan->max_width = std::max(plan->max_width, plan->width[i]);
+		sum += (i >= 1 ? plan->width[i] : 0);
+	}
+	plan->average_width = (m > 0 ? sum / m : 0.0);
+	plan->nodes.clear();
+	plan->paths.clear();
+	plan->total_nodes = 0.0;
+	plan->exact = false;
+
+	if (m > 0 && (beam_width > 0 || walks > 0)) {
+		EstimateAction action = { beam_width, walks, seed, plan };
+		DispatchPacked(state, DetectSimdLevel(), action);
+	}
+}
+
+// root から幅優先探索で頂点に番号を振り（届かない頂点は後ろに頂点番号順に並べる），
+// 番号の小さい端点，大きい端点の順に辺を並べた順序を order に格納する（同じなら元の順序）
+static void MakeBfsOrder(Graph* graph, int root, vector<int>* order)
+{
+	const vector<Edge>& edge_list = graph->GetEdgeList();
+	int n = graph->GetNumberOfVertices();
+	vector<vector<int> > adjacent(n + 1);
+	for (size_t e = 0; e < edge_list.size(); ++e) {
+		adjacent[edge_list[e].src].push_back(edge_list[e].dest);
+		adjacent[edge_list[e].dest].push_back(edge_list[e].src);
+	}
+	vector<int> rank(n + 1, -1);
+	vector<int> queue;
+	vector<int> roots(1, root);
+	for (int v = 1; v <= n; ++v) {
+		roots.push_back(v);
+	}
+	int next_rank = 0;
+	for (size_t r = 0; r < roots.size(); ++r) {
+		int u = roots[r];
+		if (rank[u] >= 0) {
+			continue;
+		}
+		rank[u] = next_rank++;
+		queue.assign(1, u);
+		for (size_t k = 0; k < queue.size(); ++k) {
+			const vector<int>& neighbors = adjacent[queue[k]];
+			for (size_t j = 0; j < neighbors.size(); ++j) {
+				if (rank[neighbors[j]] < 0) {
+					rank[neighbors[j]] = next_rank++;
+					queue.push_back(neighbors[j]);
+				}
+			}
+		}
+	}
+
+	vector<std::pair<std::pair<int, int>, int> > keys(edge_list.size());
+	for (size_t e = 0; e < edge_list.size(); ++e) {
+		int a = rank[edge_list[e].src], b = rank[edge_list[e].dest];
+		keys[e] = std::make_pair(std::make_pair(std::min(a, b), std::max(a, b)), static_cast<int>(e));
+	}
+	std::sort(keys.begin(), keys.end());
+	order->resize(keys.size());
+	for (size_t k = 0; k < keys.size(); ++k) {
+		(*order)[k] = keys[k].second;
+	}
+}
+
+bool FrontierPlanner::MakeEdgeOrder(Graph* graph, int s, const string& order,
+	vector<Edge>* edge_list, vector<int>* permutation,
+	const EdgeOrderSearchOptions& search_options)
+{
+	vector<int> sorted_order(graph->GetEdgeList().size());
+	if (order == "input") {
+		for (size_t e = 0; e < sorted_order.size(); ++e) {
+			sorted_order[e] = static_cast<int>(e);
+		}
+	} else if (order == "bfs") {
+		MakeBfsOrder(graph, s, &sorted_order);
+	} else if (order == "search") {
+		SearchEdgeOrder(graph, s, search_options, &sorted_order);
+	} else {
+		return false;
+	}
+	edge_list->clear();
+	for (size_t k = 0; k < sorted_order.size(); ++k) {
+		edge_list->push_back(graph->GetEdgeList()[sorted_order[k]]);
+	}
+	if (permutation != NULL) {
+		*permutation = sorted_order;
+	}
+	return true;
+}
+
+// 辺の順序のフロンティアの大きさを求める。作業用配列を使い回す
+class EdgeOrderScorer {
+private:
+	const vector<Edge>& edge_list_;
+	vector<int> first_;   // 頂点を含む最初の辺の位置（-1 なら含む辺がまだない）
+	vector<int> last_;    // 頂点を含む最後の辺の位置
+	vector<int> diff_;    // 位置ごとのフロンティアの大きさの増減
+	vector<int> touched_; // 現れた頂点
+
+public:
+	EdgeOrderScorer(Graph* graph) : edge_list_(graph->GetEdgeList())
+	{
+		first_.assign(graph->GetNumberOfVertices() + 1, -1);
+		last_.assign(graph->GetNumberOfVertices() + 1, -1);
+	}
+
+	// 頂点 v は位置 first_[v] から last_[v] - 1 まで（F[first_[v] + 1] から F[last_[v]] まで）
+	// フロンティアにいる
+	void Score(const vector<int>& order, int* max_width, int64_t* sum_width)
+	{
+		int m = static_cast<int>(order.size());
+		diff_.assign(m + 1, 0);
+		touched_.clear();
+		for (int k = 0; k < m; ++k) {
+			const Edge& edge = edge_list_[order[k]];
+			for (int y = 0; y <= 1; ++y) {
+				int v = (y == 0 ? edge.src : edge.dest);
+				if (first_[v] < 0) {
+					first_[v] = k;
+					touched_.push_back(v);
+				}
+				last_[v] = k;
+			}
+		}
+		int64_t sum = 0;
+		for (size_t j = 0; j < touched_.size(); ++j) {
+			int v = touched_[j];
+			++diff_[first_[v]];
+			--diff_[last_[v]];
+			sum += last_[v] - first_[v];
+			first_[v] = -1;
+		}
+		int width = 0, max = 0;
+		for (int k = 0; k < m; ++k) {
+			width += diff_[k];
+			max = std::max(max, width);
+		}
+		*max_width = max;
+		*sum_width = sum;
+	}
+};
+
+void FrontierPlanner::ScoreEdgeOrder(Graph* graph, const vector<int>& order, int* max_width,
+	int64_t* sum_width)
+{
+	EdgeOrderScorer scorer(graph);
+	scorer.Score(order, max_width, sum_width);
+}
+
+EdgeOrderSearchOptions::EdgeOrderSearchOptions()
+{
+	time_limit = 1.0;
+	num_threads = 1;
+	minimize_sum = false;
+	seed = 1;
+}
+
+// 辺の順序の焼きなまし法（SearchEdgeOrder の1スレッド分）
+class EdgeOrderAnnealer {
+private:
+	// 1スレッドの持ち時間をこの数に分け，それぞれ初期順序を変えて焼きなます
+	static const int kRunsPerThread = 4;
+
+	Graph* graph_;
+	int s_;
+	const EdgeOrderSearchOptions& options_;
+	int thread_index_;
+	EdgeOrderScorer scorer_;
+	std::mt19937_64 random_;
+
+public:
+	vector<int> best_order; // 見つけた最良の順序
+	int best_max;
+	int64_t best_sum;
+
+	EdgeOrderAnnealer(Graph* graph, int s, const EdgeOrderSearchOptions& options, int thread_index)
+		: options_(options), scorer_(graph),
+		random_(options.seed * 0x9e3779b97f4a7c15ULL + static_cast<uint64_t>(thread_index))
+	{
+		graph_ = graph;
+		s_ = s;
+		thread_index_ = thread_index;
+		best_max = 0;
+		best_sum = 0;
+	}
+
+	// (max, sum) が (best_max, best_sum) より良いか（options_.minimize_sum に従って比べる）
+	bool IsBetter(int max, int64_t sum, int other_max, int64_t other_sum)
+	{
+		if (options_.minimize_sum) {
+			return sum < other_sum || (sum == other_sum && max < other_max);
+		}
+		return max < other_max || (max == other_max && sum < other_sum);
+	}
+
+	void Run()
+	{
+		int m = static_cast<int>(graph_->GetEdgeList().size());
+		MakeBfsOrder(graph_, s_, &best_order);
+		scorer_.Score(best_order, &best_max, &best_sum);
+		if (m < 2) {
+			return;
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double run_time = options_.time_limit / kRunsPerThread;
+		vector<int> order;
+		for (int r = 0; r < kRunsPerThread; ++r) {
+			// 初期順序：最初はスレッド 0 が s からの幅優先探索順，スレッド 1 が入力順，
+			// 以後は無作為な頂点からの幅優先探索順と，それまでの最良の順序を交互に用いる
+			int slot = thread_index_ + r * options_.num_threads;
+			if (slot == 0) {
+				order = best_order;
+			} else if (slot == 1) {
+				order.resize(m);
+				for (int e = 0; e < m; ++e) {
+					order[e] = e;
+				}
+			} else if (r % 2 == 1) {
+				order = best_order;
+			} else {
+				int root = 1 + static_cast<int>(random_() % graph_->GetNumberOfVertices());
+				MakeBfsOrder(graph_, root, &order);
+			}
+			double deadline = run_time * (r + 1);
+			Anneal(&order, start, deadline - run_time, deadline);
+		}
+	}
+
+private:
+	// 焼きなまし法のエネルギー。最大値を第一にするときは，最大値の 1 を平均の 1（和の m）と同じ重みにする
+	double Energy(int max, int64_t sum)
+	{
+		int m = static_cast<int>(graph_->GetEdgeList().size());
+		return options_.minimize_sum ? static_cast<double>(sum) + max
+			: static_cast<double>(max) * m + static_cast<double>(sum);
+	}
+
+	// order[a] を位置 b に移す（a と b の間の辺はずらす）
+	static void Move(vector<int>* order, int a, int b)
+	{
+		if (a < b) {
+			std::rotate(order->begin() + a, order->begin() + a + 1, order->begin() + b + 1);
+		} else {
+			std::rotate(order->begin() + b, order->begin() + a, order->begin() + a + 1);
+		}
+	}
+
+	// 近傍の順序を作る。2辺の交換か1辺の移動で，相手の位置は半分の確率で近くから選ぶ。
+	// 元に戻すための情報を *a, *b, *swap に格納する
+	void Perturb(vector<int>* order, int* a, int* b, bool* swap)
+	{
+		int m = static_cast<int>(order->size());
+		*a = static_cast<int>(random_() % m);
+		do {
+			if (random_() % 2 == 0) {
+				*b = static_cast<int>(random_() % m);
+			} else {
+				int d = 1 + static_cast<int>(random_() % std::max(1, m / 16));
+				*b = std::min(m - 1, std::max(0, *a + (random_() % 2 == 0 ? d : -d)));
+			}
+		} while (*b == *a);
+		*swap = (random_() % 2 == 0);
+		if (*swap) {
+			std::swap((*order)[*a], (*order)[*b]);
+		} else {
+			Move(order, *a, *b);
+		}
+	}
+
+	static void Undo(vector<int>* order, int a, int b, bool swap)
+	{
+		if (swap) {
+			std::swap((*order)[a], (*order)[b]);
+		} else {
+			Move(order, b, a);
+		}
+	}
+
+	// 経過時間が [begin, end) 秒の間，order から焼きなます
+	void Anneal(vector<int>* order, std::chrono::steady_clock::time_point start,
+		double begin, double end)
+	{
+		int max, new_max, a, b;
+		int64_t sum, new_sum;
+		bool swap;
+		scorer_.Score(*order, &max, &sum);
+		Record(*order, max, sum);
+		double energy = Energy(max, sum);
+
+		// 初期温度は近傍へのエネルギーの増加量の平均にする
+		double increase = 0;
+		int samples = 0;
+		for (int k = 0; k < 64; ++k) {
+			Perturb(order, &a, &b, &swap);
+			scorer_.Score(*order, &new_max, &new_sum);
+			double delta = Energy(new_max, new_sum) - energy;
+			if (delta > 0) {
+				increase += delta;
+				++samples;
+			}
+			Undo(order, a, b, swap);
+		}
+		double t0 = std::max(1.0, samples > 0 ? increase / samples : 1.0);
+		double t1 = t0 * 1e-3;
+		double temperature = t0;
+
+		for (int64_t iteration = 0; ; ++iteration) {
+			if ((iteration & 255) == 0) { // 256 回ごとに時間を調べて温度を下げる
+				double elapsed = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - start).count();
+				if (elapsed >= end) {
+					break;
+				}
+				double progress = std::max(0.0, (elapsed - begin) / (end - begin));
+				temperature = t0 * std::pow(t1 / t0, progress);
+			}
+			Perturb(order, &a, &b, &swap);
+			scorer_.Score(*order, &new_max, &new_sum);
+			double delta = Energy(new_max, new_sum) - energy;
+			if (delta <= 0 || std::generate_canonical<double, 53>(random_)
+				< std::exp(-delta / temperature)) {
+				energy += delta;
+				Record(*order, new_max, new_sum);
+			} else {
+				Undo(order, a, b, swap);
+			}
+		}
+	}
+
+	void Record(const vector<int>& order, int max, int64_t sum)
+	{
+		if (IsBetter(max, sum, best_max, best_sum)) {
+			best_order = order;
+			best_max = max;
+			best_sum = sum;
+		}
+	}
+};
+
+void FrontierPlanner::SearchEdgeOrder(Graph* graph, int s, const EdgeOrderSearchOptions& options,
+	vector<int>* order)
+{
+	int num_threads = std::max(1, options.num_threads);
+	vector<EdgeOrderAnnealer*> annealers;
+	for (int k = 0; k < num_threads; ++k) {
+		annealers.push_back(new EdgeOrderAnnealer(graph, s, options, k));
+	}
+	vector<std::thread> threads;
+	for (int k = 1; k < num_threads; ++k) {
+		EdgeOrderAnnealer* annealer = annealers[k];
+		threads.push_back(std::thread([annealer] { annealer->Run(); }));
+	}
+	annealers[0]->Run();
+	for (size_t k = 0; k < threads.size(); ++k) {
+		threads[k].join();
+	}
+
+	int best = 0;
+	for (int k = 1; k < num_threads; ++k) {
+		if (annealers[k]->IsBetter(annealers[k]->best_max, annealers[k]->best_sum,
+				annealers[best]->best_max, annealers[best]->best_sum)) {
+			best = k;
+		}
+	}
+	order->swap(annealers[best]->best_order);
+	for (int k = 0; k < num_threads; ++k) {
+		delete annealers[k];
+	}
+}
+
+//******************************************************************************
+// 近似数え上げ
+
+// 自由度 df の t 分布の 97.5% 点（両側 95% 信頼区間に用いる）
+static double GetStudentT975(int df)
+{
+	static const double table[] = { 0.0,
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+	return (df <= 30 ? table[df] : 1.960);
+}
+
+void ApproximateCounter::Count(State* state, int beam_width, int replicates, uint64_t seed,
+	ApproximateCount* result)
+{
+	vector<double> estimates;
+	bool exact = true;
+	if (!state->graph->GetEdgeList().empty()) { // 辺がなければ解もない
+		ApproximateAction action = { std::max(1, beam_width), std::max(1, replicates), seed,
+			&estimates, &exact };
+		DispatchPacked(state, DetectSimdLevel(), action);
+	} else {
+		estimates.push_back(0.0);
+	}
+
+	int r = static_cast<int>(estimates.size());
+	double mean = 0.0;
+	for (int k = 0; k < r; ++k) {
+		mean += estimates[k] / r;
+	}
+	double variance = 0.0; // 標本分散
+	for (int k = 0; k < r; ++k) {
+		variance += (estimates[k] - mean) * (estimates[k] - mean) / std::max(1, r - 1);
+	}
+	result->estimate = mean;
+	result->replicates = r;
+	result->exact = exact;
+	result->standard_error = (exact || r < 2 ? 0.0 : std::sqrt(variance / r));
+	double half = (r >= 2 ? GetStudentT975(r - 1) * result->standard_error : 0.0);
+	result->lower = std::max(0.0, mean - half);
+	result->upper = mean + half;
+}
+
+//******************************************************************************
+// アルゴリズム名を指定してZDDを構築する。名前が不正なら NULL を返す。
+// options は packed で用いる。有向グラフと端点の組が2組以上のものは packed のみ対応する。
+ZDD* ConstructByName(const string& algorithm, State* state, const ConstructOptions& options)
+{
+	if ((state->graph->IsDirected() || state->terminal_pairs.size() >= 2)
+		&& algorithm != "packed") {
+		return NULL;
+	} else if (algorithm == "frontier") {
+		return FrontierAlgorithm::Construct(state, options.profile);
+	} else if (algorithm == "simpath") {
+		return SimpathAlgorithm::Construct(state, options.profile);
+	} else if (algorithm == "packed") {
+		return PackedFrontierAlgorithm::Construct(state, options);
+	}
+	return NULL;
+}
+
+} // namespace frontier
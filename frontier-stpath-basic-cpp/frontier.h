@@ -0,0 +1,665 @@
+//
+// frontier.h
+//
+// Copyright (c) 2014 Jun Kawahara
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// フロンティア法（s-tパスの場合）のライブラリ（libfrontier.a）のヘッダ。
+// 大域的な状態は持たないので，別々の Graph, State から ZDD を構築する限り，
+// 複数のスレッドから同時に Construct を呼んでよい。
+// ZDD の終端ノードとノードIDの発行は，構築された ZDD ごとに持つ。
+
+namespace frontier {
+
+//******************************************************************************
+// Edge 構造体
+// グラフの辺を表す。
+struct Edge {
+public:
+	int src;  // 辺の始点
+	int dest; // 辺の終点
+
+	Edge(int src_a, int dest_a)
+	{
+		src = src_a;
+		dest = dest_a;
+	}
+};
+
+//******************************************************************************
+// グラフファイルの形式
+enum GraphFormat {
+	kGraphFormatAuto = 0,     // 拡張子で判定する（Graph::DetectFormat）
+	kGraphFormatAdjList = 1,  // 隣接リスト（i 行目に頂点 i が隣接する頂点を並べる）
+	kGraphFormatEdgeList = 2, // 辺リスト（1行に辺の両端 "u v"。'#', '%' で始まる行は注釈）
+	kGraphFormatDimacs = 3    // DIMACS（"p sp n m", "a u v w" または "p edge n m", "e u v"）
+};
+
+//******************************************************************************
+// Graph 構造体
+// （無向）グラフを表す。グラフは辺のリスト(vector)によって表される。
+class Graph {
+private:
+	int number_of_vertices_; // 頂点の数
+	std::vector<Edge> edge_list_; // 辺リスト
+	bool directed_; // 有向グラフか（辺は src から dest への弧）
+
+public:
+	Graph();
+
+	int GetNumberOfVertices() // 頂点の数を返す
+	{
+		return number_of_vertices_;
+	}
+
+	const std::vector<Edge>& GetEdgeList() // 辺リストを返す
+	{
+		return edge_list_;
+	}
+
+	bool IsDirected() // 有向グラフかを返す
+	{
+		return directed_;
+	}
+
+	// 有向グラフとして扱うかを設定する（既定は無向）。読み込みの前に設定すると，
+	// 辺の向きを src < dest にそろえずに入力のまま（隣接リストでは i 行目が頂点 i から
+	// 出る弧）残し，逆向きの弧は別の辺とみなす。有向グラフは packed でのみ構築できる
+	void SetDirected(bool directed)
+	{
+		directed_ = directed;
+	}
+
+	// ファイルから隣接リスト形式のグラフを読み込む
+	void ParseAdjListText(std::istream& ist);
+
+	// メモリ上のテキスト [begin, end) を format 形式のグラフとして読み込む。
+	// 自己ループは無視し，重複する辺は最初のものだけを残す。
+	// 辺リストで頂点番号 0 が現れたら，0 始まりとみなして全体に 1 を足す。
+	// 頂点番号は非負の整数で，数でない語（"-2" のような負の数も含む）や int に収まらない数に
+	// 当たったら，その行の残りを読み飛ばす（辺リストと DIMACS ではその行の辺を読まない。
+	// 隣接リストではそれより前の隣接頂点だけを読む）。
+	void ParseText(const char* begin, const char* end, GraphFormat format);
+
+	// ファイル path を mmap して format 形式のグラフとして読み込む。
+	// kGraphFormatAuto なら拡張子で判定する。開けなければ false を返す
+	bool LoadFile(const std::string& path, GraphFormat format = kGraphFormatAuto);
+
+	// 拡張子から形式を判定する（.gr, .dimacs, .col は DIMACS，.el, .edge, .edges,
+	// .edgelist は辺リスト，それ以外は隣接リスト）
+	static GraphFormat DetectFormat(const std::string& path);
+
+	// rows x cols の格子グラフを作成する
+	void MakeGrid(int rows, int cols);
+
+	// 頂点の数と辺リスト（無向なら src < dest。多重辺があってもよい）からグラフを作成する
+	void SetEdgeList(int number_of_vertices, const std::vector<Edge>& edge_list);
+
+	std::string ToString();
+};
+
+//******************************************************************************
+// ZDDNode 構造体
+// ZDDノードを表す。
+class ZDDNode {
+public:
+	int* deg;  // deg 配列（フロンティア法アルゴリズムの文献参照）
+	int* comp; // comp 配列（フロンティア法アルゴリズムの文献参照）
+	ZDDNode* zero_child; // 0枝側の子ノード
+	ZDDNode* one_child;  // 1枝側の子ノード
+
+private:
+	int id_; // ノードID。0終端は0，1終端は1，それ以外のノードは2から始まる整数
+
+	friend class ZDD; // ID は ZDD::AddNode で振る
+
+public:
+	ZDDNode();
+	~ZDDNode();
+
+	int GetId() // IDを返す
+	{
+		return id_;
+	}
+
+	// 根(root)ノードを作成して返す。
+	static ZDDNode* CreateRootNode(int number_of_vertices);
+
+	// ZDDノードをコピーして返す。
+	ZDDNode* MakeCopy(int number_of_vertices);
+
+	// ノードに子を設定
+	void SetChild(ZDDNode* node, int child_num);
+
+	// ノードの子ノードを取得
+	ZDDNode* GetChild(int child_num);
+
+	// ZDDノードを文字列にして返す
+	std::string ToString();
+
+private:
+	ZDDNode(const ZDDNode&);            // コピー禁止
+	ZDDNode& operator=(const ZDDNode&);
+};
+
+//******************************************************************************
+// State 構造体
+
+class State
+{
+public:
+	Graph* graph; // 入力グラフ
+	int s; // s-tパスの始点の頂点番号
+	int t; // s-tパスの始点の頂点番号
+	// 端点の組。s-t パスでは (s, t) の1組。2組以上なら各組を結ぶ頂点素なパスの集合
+	// （ナンバーリンク）を求める（packed のみ対応）。s, t は最初の組と同じ
+	std::vector<std::pair<int, int> > terminal_pairs;
+	// 辺の値の固定（構築の前に設定する）。fixed_edges[e] は辺 e（GetEdgeList() の添字）の値で，
+	// -1 なら固定しない，0 なら使わない（0枝だけを作る），1 なら必ず使う（1枝だけを作る）。
+	// 空ならどの辺も固定しない
+	std::vector<int> fixed_edges;
+	std::vector<int>** F; // フロンティアを格納する2次元配列
+
+public:
+	State(Graph* g, int start, int end);
+
+	// 端点の組（1組以上。端点はすべて異なる頂点であること）を指定して作成する
+	State(Graph* g, const std::vector<std::pair<int, int> >& pairs);
+
+	// 辺 e（GetEdgeList() の添字）の x枝を作れるか（fixed_edges に反しないか）
+	bool IsAllowed(int e, int x)
+	{
+		return fixed_edges.empty() || fixed_edges[e] < 0 || fixed_edges[e] == x;
+	}
+	~State();
+
+private:
+	void ComputeFrontier(); // フロンティアの計算
+	bool FindElement(int edge_number, int value);
+
+	State(const State&);            // コピー禁止
+	State& operator=(const State&);
+};
+
+//******************************************************************************
+// ZDD の書き出し
+
+// ZDD を書き出す形式（ZDD::Export, ZDDManager::Export）
+enum ZDDFormat {
+	kFormatSapporo = 0,    // SAPPOROBDD の ZBDD::Export 形式
+	kFormatGraphillion = 1 // Graphillion の GraphSet.dump（setset）形式
+};
+
+// 形式の名前（"sapporo", "graphillion"）から ZDDFormat を求める。知らない名前なら false を返す
+bool ParseZDDFormat(const std::string& name, ZDDFormat* format);
+
+// 既約な ZDD を format の形式で out に書き出す。
+// ノードは子より先に書かなければならないので，レベル（1始まり，根が 1）の大きい方から順に
+// AddNode で1つずつ渡し，最後に Finish で根を渡す。ノードは 0終端を 0，1終端を 1，
+// それ以外を AddNode が返す 2 以上の番号で指す。書き出す文字列はバッファにためてまとめて書く。
+// SAPPOROBDD の形式は先頭に変数の数，根の数（1），ノード数を書き，各行は "ID レベル 0枝 1枝"，
+// 最後の行が根。レベルは終端に近い方が 1 なので，レベル i は 変数の数 - i + 1 に付け替える。
+// ID の最下位ビットは否定枝の印なので ID は偶数にし，終端は F, T と書く。
+// Graphillion の形式は各行が "ID 要素 0枝 1枝"，最後の行が根，終わりは "." の行。
+// 要素は根に近い方が 1 なので，レベルをそのまま書く。終端は B, T と書き，
+// 根が終端ならその1文字だけの行を書く
+class ZDDExporter
+{
+private:
+	std::ostream* out_;
+	ZDDFormat format_;
+	int number_of_variables_;
+	int64_t next_id_;    // 次に返すノードの番号
+	std::string buffer_; // まだ書いていない文字列
+
+public:
+	// number_of_variables: 変数の数（辺の数），number_of_nodes: 渡すノードの数（終端を除く）
+	ZDDExporter(std::ostream* out, ZDDFormat format, int number_of_variables,
+		int64_t number_of_nodes);
+
+	// レベル level の (lo, hi) のノードを書き，その番号を返す。hi は 0終端であってはならない
+	int64_t AddNode(int level, int64_t lo, int64_t hi);
+
+	// 根を書いて out に書き出す
+	void Finish(int64_t root);
+
+private:
+	void AppendInteger(int64_t value);
+	void AppendNode(int64_t id); // ノードの番号を形式の ID か終端の文字にして書く
+	void Flush();
+
+	ZDDExporter(const ZDDExporter&);            // コピー禁止
+	ZDDExporter& operator=(const ZDDExporter&);
+};
+
+//******************************************************************************
+// ZDD 構造体
+// ZDD のノードが node_list_array_ に格納される。
+// レベル i のノードは node_list_array_[i] に格納される。
+// i は1始まり。0は使わない。i = m + 1 はダミー。
+// レベル i の j 番目のノードは node_list_array_[i][j] で参照できる。
+// 0終端，1終端と，次に与えるノードIDは ZDD ごとに持つ。
+// ノードIDはレベル 1 から順に振られるので，各レベルのノードのIDは連続している
+// （ノードは構築中に，レベルの小さい順に AddNode されなければならない）。
+class ZDD
+{
+private:
+	std::vector<std::vector<ZDDNode*> > node_list_array_;
+	ZDDNode zero_terminal_; // 0終端
+	ZDDNode one_terminal_;  // 1終端
+	int total_id_;          // 次に与えるノードID
+	// Renumber で作る子の ID の表。child_ids_[2 * id + x] は ID が id のノードの x枝の先の ID。
+	// 空なら作っていない（ノードをたどる）
+	std::vector<int> child_ids_;
+
+public:
+	// number_of_levels: node_list_array_ の大きさ（辺の数 + 2）
+	explicit ZDD(int number_of_levels);
+	~ZDD();
+
+	ZDDNode* GetZeroTerminal() // 0終端を返す
+	{
+		return &zero_terminal_;
+	}
+
+	ZDDNode* GetOneTerminal() // 1終端を返す
+	{
+		return &one_terminal_;
+	}
+
+	// node に次のIDを振って，レベル level に追加する
+	void AddNode(int level, ZDDNode* node);
+
+	// レベル level のノードの配列を返す
+	const std::vector<ZDDNode*>& GetNodeList(int level)
+	{
+		return node_list_array_[level];
+	}
+
+	// 振ったノードIDの数（終端を含む）を返す。ノードIDで引く配列の大きさに用いる
+	int GetNumberOfIds()
+	{
+		return total_id_;
+	}
+
+	// ZDDのノード数を返す
+	int64_t GetNumberOfNodes();
+
+	// ZDDが表現する集合族の大きさ（解の個数）を返す。
+	// num_threads 個のスレッドで ForEachLevelBottomUp を用いて計算する。
+	int64_t GetNumberOfSolutions(int num_threads = 1);
+
+	// 1回の走査でまとめて評価する重みベクトルの数。ノードごとに double をこの数だけ
+	// 並べた行（64 バイト，キャッシュライン1本分）を持ち，行ごとに SIMD 命令で計算する
+	static const int kWeightRowWidth = 8;
+
+	// 重みベクトル weights[k]（大きさは辺の数。weights[k][e] は辺 e（GetEdgeList() の添字）の重み）ごとに，
+	// 解（辺の集合）の重みの和の最小値（maximize なら最大値）を求めて (*results)[k] に格納する。
+	// 解がなければ +inf（maximize なら -inf）。kWeightRowWidth 個の重みベクトルを
+	// ノード表の1回の走査でまとめて計算するので，重みベクトルごとに走査するより
+	// メモリの読み出しが少ない。num_threads は GetNumberOfSolutions と同じ
+	void EvaluateWeights(const std::vector<std::vector<double> >& weights, bool maximize,
+		std::vector<double>* results, int num_threads = 1);
+
+	// 辺（レベル。1始まり）levels を削除したグラフの解の集合族になるように，ZDD をその場で更新する
+	// （構築し直さない）。削除する辺のレベルの1枝を0終端にし，そのうち最大のレベル以下だけを
+	// 下から既約にし直す（解のないノードを0終端に，子の等しいノードを1つにまとめる）。
+	// 子がすぐ下のレベルか終端であることは保つので，1枝だけが0終端のノードは残す。根は必ず残す。
+	// 最後に根から到達できないノードを解放し，ノードIDをレベル 1 から振り直す。
+	// 解の個数などは更新した ZDD について GetNumberOfSolutions などで求める
+	void DeleteEdges(const std::vector<int>& levels);
+
+	// 各レベルのノードを親の順（1つ上のレベルのノードを順に見て，0枝，1枝の順に初めて参照された順。
+	// 参照されないノードは元の順で後ろに置く）に並べ替えてノードIDを振り直し，子の ID の表を作る。
+	// 以後の GetNumberOfSolutions と EvaluateWeights はノードをたどらずに ID の順に表を読むので，
+	// 親の行と子の行を読む位置がそろってキャッシュとプリフェッチが効く（構築の途中で ID の順が
+	// 崩れた ZDD，たとえば複数プロセスで構築したものでも同じになる）。表は辺 1 本あたり 8 バイト。
+	// 表を作った後に AddNode でノードを加えると表は捨てる（DeleteEdges は作り直す）。
+	// 子はすぐ下のレベルか終端でなければならない（構築した ZDD はそうなっている）
+	void Renumber();
+
+	// レベルの高い方から低い方へ（子から親へ）順に，各レベル i のノードを
+	// num_threads 個のスレッドで分担して func(i, begin, end) を呼ぶ。
+	// [begin, end) はレベル i のノードの配列（GetNodeList(i)）の添字の範囲。
+	// レベル i の処理はレベル i + 1 以上の処理がすべて終わってから始まるので，
+	// 子ノードの値から親ノードの値を求める動的計画法に使える。
+	// 分担の境界はノードIDが 8 の倍数になる位置にそろえるので，ノードIDで引く
+	// 64 ビット値の配列（先頭を 64 バイト境界にそろえたもの）に書き込むとき，
+	// 異なるスレッドが同じキャッシュラインに書き込むことはない。
+	void ForEachLevelBottomUp(int num_threads,
+		const std::function<void(int level, size_t begin, size_t end)>& func);
+
+	// ZDDを文字列にして返す
+	std::string GetZDDString();
+
+	// 既約にしながら（1枝が0終端のノードを0枝の先に，子の等しいノードを1つにまとめながら），
+	// ZDDExporter で format の形式にして out に書き出す。文字列は作らない。
+	// 各レベルを下から1度ずつ見て各ノードの行き先の番号を決め（ノード ID あたり 4 バイト），
+	// 数えたノード数を書いてから同じ順に見てノードを書く
+	void Export(std::ostream* out, ZDDFormat format);
+
+private:
+	ZDD(const ZDD&);            // コピー禁止
+	ZDD& operator=(const ZDD&);
+};
+
+//******************************************************************************
+// アルゴリズム本体
+
+// 詰めた状態表現の比較，ハッシュ値の計算，comp の付け替えに用いる SIMD 命令セット
+enum SimdLevel {
+	kSimdScalar = 0, // SIMD 命令を使わない
+	kSimdSse2 = 1,   // SSE2（x86-64 では常に使える）
+	kSimdAvx2 = 2    // AVX2（実行時に CPU が対応しているか調べる）
+};
+
+// 実行中の CPU で使える最も新しい SIMD 命令セットを返す
+SimdLevel DetectSimdLevel();
+
+// SIMD 命令セットの名前（"scalar", "sse2", "avx2"）を返す
+const char* GetSimdLevelName(SimdLevel level);
+
+// メモリ使用量の分類（MemoryProfile）
+enum MemoryCategory {
+	kMemoryNode = 0,   // ZDD のノード（ZDDNode 本体）
+	kMemoryLevel = 1,  // 各レベルのノードの配列（ZDD の N_i）
+	kMemoryState = 2,  // ノードの状態（deg/comp 配列，詰めた状態）
+	kMemoryTable = 3,  // 状態の重複除去に用いるハッシュ表
+	kMemoryOutput = 4, // 出力（ZDD の文字列）
+	kNumberOfMemoryCategories = 5
+};
+
+// 分類ごとのメモリ使用量（確保した配列の容量から数えたバイト数。malloc の管理領域は含まない）。
+// ConstructOptions::profile に指定すると，構築中に各分類の現在の使用量と最大値，
+// 各レベルの構築を終えた時点の使用量を記録する（指定しなければ数えない）。
+// 状態表は次のレベルを作り終えた時点で最も大きいので，最大値はレベルの境界で測る
+class MemoryProfile {
+public:
+	int64_t current[kNumberOfMemoryCategories]; // 現在の使用量
+	int64_t peak[kNumberOfMemoryCategories];    // 分類ごとの最大値
+	int64_t peak_total; // 合計の最大値
+	// levels[i][c] はレベル i の構築を終えた時点（レベル i + 1 の状態を作り終え，
+	// レベル i の状態を捨てる前）の分類 c の使用量。levels[0] は使わない
+	std::vector<std::vector<int64_t> > levels;
+
+	MemoryProfile();
+
+	// 分類 category の現在の使用量を bytes にする（最大値も更新する）
+	void Set(MemoryCategory category, int64_t bytes);
+
+	// 現在の使用量をレベル level のものとして記録する
+	void EndLevel(int level);
+
+	// 現在の使用量の合計
+	int64_t GetTotal();
+
+	// 分類の名前（"node", "level", "state", "table", "output"）を返す
+	static const char* GetCategoryName(MemoryCategory category);
+};
+
+// フロンティア法（deg/comp 版）
+class FrontierAlgorithm {
+
+public:
+	// フロンティア法を実行し，ZDDを作成して返す。
+	// profile が NULL でなければメモリ使用量を記録する（MemoryProfile）
+	static ZDD* Construct(State* state, MemoryProfile* profile = NULL);
+
+private:
+	static ZDDNode* CheckTerminal(ZDD* zdd, ZDDNode* n_hat, int i, int x, State* state);
+	static void UpdateInfo(ZDDNode* n_hat, int i, int x, State* state);
+	static ZDDNode* Find(ZDDNode* n_prime, const std::vector<ZDDNode*>& N_i, int i, State* state);
+	static bool IsEquivalent(ZDDNode* node1, ZDDNode* node2, int i, State* state);
+};
+
+// Knuth 氏の simpath による ZDD 構築（mate 配列版）
+class SimpathAlgorithm {
+
+public:
+	// simpath を実行し，ZDDを作成して返す。
+	// profile が NULL でなければメモリ使用量を記録する（MemoryProfile）
+	static ZDD* Construct(State* state, MemoryProfile* profile = NULL);
+
+private:
+	static void ComputeMateFrontier(State* state, std::vector<std::vector<int> >* MF);
+	static ZDDNode* CheckTerminalPre(ZDD* zdd, std::vector<int>* mate, const Edge& edge, int x,
+		const std::vector<int>& prev_frontier);
+	static void Update(std::vector<int>* mate, const Edge& edge, int x);
+	static ZDDNode* CheckTerminalPost(ZDD* zdd, const std::vector<int>& mate,
+		const std::vector<int>& leaving, bool is_last_edge);
+};
+
+// メモリ予算を超えそうになったときに切り替えた構築方法
+enum ConstructFallback {
+	kFallbackNone = 0,      // 切り替えずに ZDD を構築した
+	kFallbackCountOnly = 1, // 子へのポインタ（ZDD）を捨て，解の個数だけを数えた
+	kFallbackSpill = 2      // さらに次のレベルの状態表をディスクに書き出し，分割して重複除去した
+};
+
+// 構築の結果の報告（ConstructOptions::report）
+struct ConstructReport {
+	ConstructFallback fallback;
+	int fallback_level;          // 切り替えたレベル（切り替えなければ 0）
+	int spill_level;             // kFallbackSpill に切り替えたレベル（切り替えなければ 0）
+	int64_t number_of_solutions; // 切り替えたときの解の個数（ディスクの読み書きに失敗したら -1）
+	int64_t peak_memory;         // 見積もったメモリ使用量の最大値（バイト）
+};
+
+class ConstructWorkspace;
+
+// ZDD 構築の設定（packed で用いる）
+struct ConstructOptions {
+	SimdLevel simd; // SIMD 命令セット（DetectSimdLevel() の返り値以下）。既定は DetectSimdLevel()
+
+	// チェックポイントを書き出すディレクトリ。空（既定）なら書き出さない。
+	// 構築の終わったレベルの子ノードを順にディレクトリ内のファイルに追記し，
+	// checkpoint_interval 秒ごとに，レベルの境界で構築中のレベルの状態を書き出す。
+	// 書き出しは別スレッドで行う。
+	std::string checkpoint_directory;
+	double checkpoint_interval; // チェックポイントの間隔（秒）。既定は 60
+	bool resume; // true なら checkpoint_directory の最後のチェックポイントから再開する
+
+	// 1 より大きければ，num_processes 個のワーカープロセスを fork し，各レベルの状態を
+	// ハッシュ値でワーカーに振り分けて構築する（呼び出したプロセスは ZDD のノードだけを持つ）。
+	// 状態のやりとりには shard_directory（既定は /dev/shm）に作る一時ディレクトリを用いる。
+	// fork を用いるので，他のスレッドが動いている間は使わないこと。チェックポイントとは併用できない。
+	int num_processes;
+	std::string shard_directory;
+
+	// メモリ予算（バイト）。0（既定）なら制限しない。ZDD のノードと状態表の大きさを数えておき，
+	// 次のレベルで予算を超えると見積もられたとき（またはレベルの途中で超えたとき）は，
+	// ZDD を捨てて解の個数だけを数える方法に切り替える。それでも超えるときは，次のレベルの
+	// 状態をハッシュ値で分割して spill_directory（既定は /tmp）のファイルに書き出し，
+	// 区画ごとに重複除去する。切り替えたときは Construct は NULL を返し，解の個数などを
+	// report に格納する。
+	int64_t memory_budget;
+	std::string spill_directory;
+	ConstructReport* report; // NULL でなければ構築の結果の報告を格納する
+	// NULL でなければ分類ごと・レベルごとのメモリ使用量を記録する（すべてのアルゴリズムで使える。
+	// packed で複数プロセスによる構築と，解の個数だけを数える方法に切り替えた後は記録しない）
+	MemoryProfile* profile;
+	// NULL でなければ，状態表（状態の配列と重複除去のハッシュ表）をここから取り出し，
+	// 使い終わったら空にして返す（解放しない）。同じ workspace で何度も構築するとき，
+	// 前の構築で確保した領域をそのまま使える（確保を省けるだけで，速くなることは確かめていない）。
+	// メモリ予算を指定したとき（見積もりは新しく作った状態表の大きさで行う）と複数プロセスによる構築では用いない
+	ConstructWorkspace* workspace;
+
+	ConstructOptions();
+};
+
+// 構築をまたいで使い回す packed の状態表の置き場（ConstructOptions::workspace）。
+// 状態表の型（幅と SIMD 命令セットで決まる）ごとに，空にした状態表を取っておく。
+// 複数のスレッドで同時に使ってはならない（スレッドごとに1つ持つ）
+class ConstructWorkspace {
+private:
+	struct Pool {
+		const void* type;           // 状態表の型（型ごとに異なる静的変数のアドレス）
+		std::vector<void*> tables;  // 空にして取っておいた状態表
+		void (*destroy)(void*);     // 状態表を解放する関数
+		int64_t (*memory_usage)(void*); // 状態表が確保しているメモリの大きさを返す関数
+	};
+	std::vector<Pool> pools_;
+
+	friend class WorkspaceAccess; // 状態表の出し入れは frontier.cpp で行う
+
+public:
+	ConstructWorkspace();
+	~ConstructWorkspace(); // 取っておいた状態表を解放する
+
+	// 取っておいた状態表の数
+	int GetNumberOfTables();
+
+	// 取っておいた状態表が確保しているメモリの大きさ（バイト）
+	int64_t GetMemoryUsage();
+
+private:
+	ConstructWorkspace(const ConstructWorkspace&);            // コピー禁止
+	ConstructWorkspace& operator=(const ConstructWorkspace&);
+};
+
+// 詰めた状態表現によるフロンティア法（deg/comp 版）
+class PackedFrontierAlgorithm {
+public:
+	// フロンティアの大きさの最大値に応じて幅を固定した実装に振り分け，ZDDを作成して返す。
+	// options.simd に応じてカーネルを選ぶ。
+	// 再開に失敗したとき（チェックポイントがない，別の入力のものであるなど），
+	// 複数プロセスによる構築に失敗したとき，メモリ予算のために解の個数だけを数える方法に
+	// 切り替えたとき（options.report を参照）は NULL を返す。
+	static ZDD* Construct(State* state, const ConstructOptions& options);
+};
+
+// ZDD を構築せずに s-t パスについての問いに答える（答えが決まった時点で探索をやめる）。
+// packed と同じ状態表現で，1枝を先に深さ優先探索する。各レベルで調べ終えた状態と
+// その先の解の数を覚えておき，解のない状態は二度と調べない。
+// パスは辺の番号（GetEdgeList() の添字，0始まり）の昇順の配列で表す。
+class PathQuery {
+public:
+	// s-t パスが存在するか。存在して path が NULL でなければ，1本を path に格納する
+	static bool Exists(State* state, std::vector<int>* path);
+
+	// s-t パスの数を返す。ただし cap 本以上あることが分かった時点で探索をやめて cap を返す
+	static int64_t CountUpTo(State* state, int64_t cap);
+
+	// s-t パスを（探索順に）最大 k 本求めて paths に格納し，その本数を返す
+	static int64_t FindPaths(State* state, int64_t k, std::vector<std::vector<int> >* paths);
+};
+
+// 近似数え上げの結果（ApproximateCounter::Count）
+struct ApproximateCount {
+	double estimate;       // 解の個数の推定値（反復の平均）
+	double standard_error; // 推定値の標準誤差（反復の間のばらつきから求める）
+	double lower;          // 95% 信頼区間の下限（0 未満にはしない）
+	double upper;          // 95% 信頼区間の上限
+	int replicates;        // 反復した回数
+	bool exact;            // 間引きを行わずに求めた厳密な値か
+};
+
+// 厳密な構築にはフロンティアが大きすぎるグラフの解の個数を，逐次モンテカルロ法で推定する
+// （packed と同じ状態表現と遷移を用いるので，有向グラフ，端点の組，辺の固定にも使える）。
+// 各レベルで状態を最大 beam_width 個まで残し，それぞれに根からの経路数の推定値（重み）を持たせる。
+// 同じ状態になった子の重みは足し合わせ，beam_width 個を超えたら重みに比例する系統抽出で
+// beam_width 個に間引く（選ばれた状態の重みは，選ばれた回数 × 重みの和 / beam_width）。
+// 1終端に届いた重みの和が1回分の推定値で，その期待値は解の個数に等しい（不偏）。
+// これを replicates 回繰り返し，平均，標準誤差と t 分布による 95% 信頼区間を求める。
+// 時間とメモリは beam_width に比例する。状態が beam_width 個を超えなければ間引きは起きず，
+// 厳密な値を1回で求める
+class ApproximateCounter {
+public:
+	static void Count(State* state, int beam_width, int replicates, uint64_t seed,
+		ApproximateCount* result);
+};
+
+// 辺の順序の見積もり（FrontierPlanner::Estimate の結果）。
+// 添字 i はレベル（辺の番号 + 1）で，width は 0 から，ほかは 1 から使う。
+struct FrontierPlan {
+	int number_of_levels;       // レベルの数（辺の数）
+	int max_width;              // フロンティアの大きさの最大値
+	double average_width;       // フロンティアの大きさ |F[1]|, ..., |F[m]| の平均
+	std::vector<int> width;     // width[i] は |F[i]|
+	std::vector<double> nodes;  // nodes[i] はレベル i のノード数の推定値（beam_width > 0 のとき）
+	std::vector<double> paths;  // paths[i] は根からレベル i への経路数の推定値（walks > 0 のとき）
+	double total_nodes;         // nodes の合計
+	bool exact;                 // nodes が抽出を行わずに求めた厳密な値か
+};
+
+// 辺の順序の探索（FrontierPlanner::SearchEdgeOrder）の設定
+struct EdgeOrderSearchOptions {
+	double time_limit; // 探索に使う時間（秒）。既定は 1
+	int num_threads;   // 並行に探索するスレッドの数。既定は 1
+	// true ならフロンティアの大きさの和（平均）を，false（既定）なら最大値を第一に小さくする
+	// （もう一方は同点のときに比べる）
+	bool minimize_sum;
+	uint64_t seed; // 乱数の種。既定は 1
+
+	EdgeOrderSearchOptions();
+};
+
+// ZDD を構築せずに，辺の順序の良し悪しを見積もる（乾燥運転）。
+// フロンティアの大きさは State::ComputeFrontier の結果だけから求める。
+// ノード数は次の2通りで見積もる（packed と同じ状態表現と遷移を用いる）。
+//  - 抽出：各レベルの状態を最大 beam_width 個だけ無作為に残して子を作り，
+//    抽出した親の間で見えた子の併合の割合からレベル全体の子の数を推定する。
+//    レベルが beam_width 個に収まるうちは厳密。あふれた後は目安（格子では数割の誤差）。
+//  - 無作為歩行（Knuth の方法）：根から0終端でない枝を無作為に選んで下り，
+//    各レベルでの分岐数の積の平均を取る。併合を数えない経路数なので，ノード数の上界になる。
+class FrontierPlanner {
+public:
+	// beam_width, walks が 0 なら，それぞれの見積もりを行わない
+	static void Estimate(State* state, int beam_width, int walks, uint64_t seed,
+		FrontierPlan* plan);
+
+	// 名前で指定した辺の順序（"input" は入力のまま，"bfs" は s からの幅優先探索で
+	// 頂点に振った番号の順に並べ替えたもの，"search" は SearchEdgeOrder で search_options に従って
+	// 探したもの）で graph の辺を並べた配列を edge_list に格納する。
+	// permutation が NULL でなければ，並べ替えた k 番目の辺の元の添字を permutation[k] に格納する。
+	// 名前が不正なら false を返す
+	static bool MakeEdgeOrder(Graph* graph, int s, const std::string& order,
+		std::vector<Edge>* edge_list, std::vector<int>* permutation = NULL,
+		const EdgeOrderSearchOptions& search_options = EdgeOrderSearchOptions());
+
+	// graph の辺を order の順（order[k] は k 番目に処理する辺の元の添字）に並べたときの
+	// フロンティアの大きさ（State::ComputeFrontier と同じもの）の最大値と和を返す。
+	// 頂点 v は，v を含む最初の辺から最後の辺の1つ前までフロンティアにいるので，O(m) で求まる
+	static void ScoreEdgeOrder(Graph* graph, const std::vector<int>& order, int* max_width,
+		int64_t* sum_width);
+
+	// フロンティアの大きさの最大値（または和）が小さい辺の順序を，options.time_limit 秒の間
+	// options.num_threads 個のスレッドで探し，見つけた最良のものを order に格納する。
+	// 各スレッドは初期順序（s からの幅優先探索順，入力順，無作為な頂点からの幅優先探索順）を
+	// 変えながら，2辺の交換と1辺の移動による焼きなまし法を繰り返す（評価は ScoreEdgeOrder）
+	static void SearchEdgeOrder(Graph* graph, int s, const EdgeOrderSearchOptions& options,
+		std::vector<int>* order);
+};
+
+// アルゴリズム名（"frontier", "simpath", "packed"）を指定してZDDを構築する。
+// 名前が不正なとき，有向グラフまたは端点の組が2組以上の State で packed 以外を
+// 指定したときは NULL を返す。options は packed で用いる。
+ZDD* ConstructByName(const std::string& algorithm, State* state, const ConstructOptions& options);
+
+} // namespace frontier
+
+#endif // FRONTIER_H
@@ -0,0 +1,322 @@
+//
+// reduce.cpp
+//
+// Copyright (c) 2014 Jun Kawahara
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "reduce.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace frontier {
+
+// 多重辺を含むグラフの隣接リスト。adjacency[v] は (隣接する頂点, 辺の番号) の配列
+typedef vector<vector<pair<int, int> > > AdjacencyList;
+
+// 辺を2連結成分（ブロック）に分ける（Tarjan の方法を再帰を使わずに書いたもの）。
+// block_of_edge[e] に辺 e のブロック番号を格納し，ブロックの数を返す。
+// 多重辺を正しく扱うため，木の親へは頂点ではなく辺の番号で戻らないようにする。
+static int ComputeBlocks(int n, const AdjacencyList& adjacency, vector<int>* block_of_edge)
+{
+	struct Frame {
+		int v;           // 頂点
+		int parent_edge; // 親から来た辺（根なら -1）
+		size_t next;     // 次に調べる隣接リストの位置
+	};
+	vector<int> order(n + 1, 0), low(n + 1, 0);
+	vector<int> edge_stack;
+	vector<Frame> stack;
+	int counter = 0;
+	int number_of_blocks = 0;
+
+	for (int root = 1; root <= n; ++root) {
+		if (order[root] != 0 || adjacency[root].empty()) {
+			continue;
+		}
+		order[root] = low[root] = ++counter;
+		Frame root_frame = { root, -1, 0 };
+		stack.push_back(root_frame);
+		while (!stack.empty()) {
+			Frame& f = stack.back();
+			if (f.next < adjacency[f.v].size()) {
+				int w = adjacency[f.v][f.next].first;
+				int e = adjacency[f.v][f.next].second;
+				++f.next;
+				if (e == f.parent_edge) {
+					continue;
+				}
+				if (order[w] == 0) { // 木の辺
+					edge_stack.push_back(e);
+					order[w] = low[w] = ++counter;
+					Frame frame = { w, e, 0 };
+					stack.push_back(frame); // f は無効になる
+				} else if (order[w] < order[f.v]) { // 祖先への後退辺
+					edge_stack.push_back(e);
+					low[f.v] = std::min(low[f.v], order[w]);
+				}
+			} else {
+				int v = f.v;
+				int parent_edge = f.parent_edge;
+				stack.pop_back();
+				if (!stack.empty()) {
+					int u = stack.back().v;
+					low[u] = std::min(low[u], low[v]);
+					if (low[v] >= order[u]) { // u で切れるので，辺 parent_edge までが1つのブロック
+						int e;
+						do {
+							e = edge_stack.back();
+							edge_stack.pop_back();
+							(*block_of_edge)[e] = number_of_blocks;
+						} while (e != parent_edge);
+						++number_of_blocks;
+					}
+				}
+			}
+		}
+	}
+	return number_of_blocks;
+}
+
+// ブロック（辺の番号の配列 block_edges）から，入口 entry，出口 exit の核を作る。
+// 入口，出口以外の次数 2 の頂点を縮約する。縮約した頂点の数を返す。
+static int MakeCore(const vector<Edge>& edge_list, const vector<int>& block_edges,
+	int entry, int exit, ReducedCore* core)
+{
+	// 縮約中の辺。鎖 chain は元の辺の番号の並び
+	struct ChainEdge {
+		int a, b;
+		vector<int> chain;
+		bool alive;
+	};
+	vector<ChainEdge> edges;
+	vector<int> vertices; // ブロックの頂点（元の番号）
+	for (size_t k = 0; k < block_edges.size(); ++k) {
+		const Edge& edge = edge_list[block_edges[k]];
+		ChainEdge chain_edge = { edge.src, edge.dest, vector<int>(1, block_edges[k]), true };
+		edges.push_back(chain_edge);
+		vertices.push_back(edge.src);
+		vertices.push_back(edge.dest);
+	}
+	std::sort(vertices.begin(), vertices.end());
+	vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+	// 頂点の位置（vertices の添字）ごとの接続する辺と次数
+	int size = static_cast<int>(vertices.size());
+	vector<vector<int> > incident(size);
+	vector<int> degree(size, 0);
+	for (size_t e = 0; e < edges.size(); ++e) {
+		edges[e].a = static_cast<int>(std::lower_bound(vertices.begin(), vertices.end(), edges[e].a)
+			- vertices.begin());
+		edges[e].b = static_cast<int>(std::lower_bound(vertices.begin(), vertices.end(), edges[e].b)
+			- vertices.begin());
+		incident[edges[e].a].push_back(static_cast<int>(e));
+		incident[edges[e].b].push_back(static_cast<int>(e));
+		++degree[edges[e].a];
+		++degree[edges[e].b];
+	}
+	int entry_pos = static_cast<int>(std::lower_bound(vertices.begin(), vertices.end(), entry)
+		- vertices.begin());
+	int exit_pos = static_cast<int>(std::lower_bound(vertices.begin(), vertices.end(), exit)
+		- vertices.begin());
+
+	int contracted = 0;
+	vector<int> work;
+	for (int v = 0; v < size; ++v) {
+		work.push_back(v);
+	}
+	while (!work.empty()) {
+		int v = work.back();
+		work.pop_back();
+		if (v == entry_pos || v == exit_pos || degree[v] != 2) {
+			continue;
+		}
+		int e1 = -1, e2 = -1; // v に接続する生きている2本の辺
+		for (size_t k = 0; k < incident[v].size(); ++k) {
+			if (edges[incident[v][k]].alive) {
+				(e1 < 0 ? e1 : e2) = incident[v][k];
+			}
+		}
+		int a = (edges[e1].a == v ? edges[e1].b : edges[e1].a);
+		int b = (edges[e2].a == v ? edges[e2].b : edges[e2].a);
+		edges[e1].alive = edges[e2].alive = false;
+		degree[v] = 0;
+		++contracted;
+		if (a == b) { // v は a との間の2重辺の先にあるので，v を通るパスはない
+			degree[a] -= 2;
+			work.push_back(a);
+			continue;
+		}
+		ChainEdge chain_edge = { a, b, edges[e1].chain, true };
+		chain_edge.chain.insert(chain_edge.chain.end(), edges[e2].chain.begin(), edges[e2].chain.end());
+		edges.push_back(chain_edge);
+		incident[a].push_back(static_cast<int>(edges.size()) - 1);
+		incident[b].push_back(static_cast<int>(edges.size()) - 1);
+	}
+
+	// 残った頂点に元の番号の順に 1 から番号を振り直し，辺を元の辺の順に並べる
+	vector<int> new_number(size, 0);
+	core->original_vertices.clear();
+	for (int v = 0; v < size; ++v) {
+		if (degree[v] > 0 || v == entry_pos || v == exit_pos) {
+			core->original_vertices.push_back(vertices[v]);
+			new_number[v] = static_cast<int>(core->original_vertices.size());
+		}
+	}
+	vector<pair<int, int> > order; // (鎖の最小の元の辺の番号, 辺)
+	for (size_t e = 0; e < edges.size(); ++e) {
+		if (edges[e].alive) {
+			int first = *std::min_element(edges[e].chain.begin(), edges[e].chain.end());
+			order.push_back(make_pair(first, static_cast<int>(e)));
+		}
+	}
+	std::sort(order.begin(), order.end());
+	vector<Edge> core_edges;
+	core->original_edges.clear();
+	for (size_t k = 0; k < order.size(); ++k) {
+		const ChainEdge& chain_edge = edges[order[k].second];
+		Edge edge(new_number[chain_edge.a], new_number[chain_edge.b]);
+		if (edge.src > edge.dest) { // src < dest になるように格納
+			std::swap(edge.src, edge.dest);
+		}
+		core_edges.push_back(edge);
+		core->original_edges.push_back(chain_edge.chain);
+	}
+	core->graph.SetEdgeList(static_cast<int>(core->original_vertices.size()), core_edges);
+	core->s = new_number[entry_pos];
+	core->t = new_number[exit_pos];
+	return contracted;
+}
+
+void ReduceGraph(Graph* graph, int s, int t, ReducedGraph* result)
+{
+	int n = graph->GetNumberOfVertices();
+	const vector<Edge>& edge_list = graph->GetEdgeList();
+	int m = static_cast<int>(edge_list.size());
+
+	result->connected = false;
+	result->forced_edges.clear();
+	result->cores.clear();
+	result->number_of_removed_edges = m;
+	result->number_of_contracted_vertices = 0;
+	if (s < 1 || t < 1 || s > n || t > n || s == t) { // 頂点がない（空のグラフ）か s = t なら解はない
+		return;
+	}
+
+	AdjacencyList adjacency(n + 1);
+	for (int e = 0; e < m; ++e) {
+		if (edge_list[e].src != edge_list[e].dest) { // 自己ループを通るパスはない
+			adjacency[edge_list[e].src].push_back(make_pair(edge_list[e].dest, e));
+			adjacency[edge_list[e].dest].push_back(make_pair(edge_list[e].src, e));
+		}
+	}
+	vector<int> block_of_edge(m, -1);
+	int number_of_blocks = ComputeBlocks(n, adjacency, &block_of_edge);
+
+	// ブロック・切断点木。頂点 v は節点 v，ブロック b は節点 n + 1 + b
+	vector<vector<int> > block_edges(number_of_blocks);
+	vector<vector<int> > tree(n + 1 + number_of_blocks);
+	for (int e = 0; e < m; ++e) {
+		int b = block_of_edge[e];
+		if (b < 0) {
+			continue;
+		}
+		block_edges[b].push_back(e);
+		int vs[2] = { edge_list[e].src, edge_list[e].dest };
+		for (int k = 0; k < 2; ++k) {
+			vector<int>& nodes = tree[vs[k]];
+			if (std::find(nodes.begin(), nodes.end(), n + 1 + b) == nodes.end()) {
+				nodes.push_back(n + 1 + b);
+				tree[n + 1 + b].push_back(vs[k]);
+			}
+		}
+	}
+
+	// s から t への木の上の道を幅優先探索で求める
+	vector<int> parent(tree.size(), -1);
+	vector<int> queue(1, s);
+	parent[s] = s;
+	for (size_t q = 0; q < queue.size() && parent[t] < 0; ++q) {
+		int x = queue[q];
+		for (size_t k = 0; k < tree[x].size(); ++k) {
+			if (parent[tree[x][k]] < 0) {
+				parent[tree[x][k]] = x;
+				queue.push_back(tree[x][k]);
+			}
+		}
+	}
+	if (parent[t] < 0) {
+		return;
+	}
+	result->connected = true;
+
+	// 道 t, B_k, c_{k-1}, ..., B_1, s を s 側から順に核にする
+	vector<int> path;
+	for (int x = t; x != s; x = parent[x]) {
+		path.push_back(x);
+	}
+	path.push_back(s);
+	std::reverse(path.begin(), path.end());
+	for (size_t k = 1; k + 1 < path.size(); k += 2) {
+		const vector<int>& edges = block_edges[path[k] - n - 1];
+		result->number_of_removed_edges -= static_cast<int>(edges.size());
+		if (edges.size() == 1) { // 橋
+			result->forced_edges.push_back(edges[0]);
+			continue;
+		}
+		result->cores.push_back(ReducedCore());
+		result->number_of_contracted_vertices += MakeCore(edge_list, edges,
+			path[k - 1], path[k + 1], &result->cores.back());
+	}
+}
+
+ZDDManager::NodeId ExpandReducedGraph(const ReducedGraph& reduced,
+	const vector<ZDD*>& core_zdds, ZDDManager* manager)
+{
+	if (!reduced.connected) {
+		return 0;
+	}
+	ZDDManager::NodeId f = 1; // 橋だけからなる集合
+	for (size_t k = 0; k < reduced.forced_edges.size(); ++k) {
+		f = manager->Change(f, reduced.forced_edges[k] + 1);
+	}
+	for (size_t k = 0; k < reduced.cores.size(); ++k) {
+		const ReducedCore& core = reduced.cores[k];
+		ZDD* zdd = core_zdds[k];
+		// id_map[ZDDNode の ID] は取り込んだノード。子から親へ（レベルの大きい方から）取り込む
+		vector<ZDDManager::NodeId> id_map(zdd->GetNumberOfIds(), 0);
+		id_map[1] = f;
+		for (int i = static_cast<int>(core.original_edges.size()); i >= 1; --i) {
+			const vector<ZDDNode*>& N_i = zdd->GetNodeList(i);
+			const vector<int>& chain = core.original_edges[i - 1];
+			for (size_t j = 0; j < N_i.size(); ++j) {
+				ZDDManager::NodeId hi = id_map[N_i[j]->GetChild(1)->GetId()];
+				for (size_t c = 0; c < chain.size(); ++c) {
+					hi = manager->Change(hi, chain[c] + 1);
+				}
+				id_map[N_i[j]->GetId()] = manager->Union(id_map[N_i[j]->GetChild(0)->GetId()], hi);
+			}
+		}
+		const vector<ZDDNode*>& roots = zdd->GetNodeList(1);
+		f = (roots.empty() ? 0 : id_map[roots[0]->GetId()]);
+	}
+	return f;
+}
+
+} // namespace frontier
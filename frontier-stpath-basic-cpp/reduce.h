@@ -0,0 +1,74 @@
+//
+// reduce.h
+//
+// Copyright (c) 2014 Jun Kawahara
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef FRONTIER_REDUCE_H
+#define FRONTIER_REDUCE_H
+
+#include <vector>
+
+#include "frontier.h"
+#include "zddmanager.h"
+
+// s-t パスの数え上げのためのグラフの前処理。
+// s-t パスが通りうるのは，ブロック・切断点木（2連結成分と切断点からなる木）で
+// s から t に至る道の上のブロックの辺だけである。それ以外（s, t を含まない木状の
+// 部分など）を除き，道の上のブロックごとに「核」を作る。s-t パスは各ブロックを
+// 入口（s または切断点）から出口（切断点または t）へ通るので，s-t パスの数は
+// 各核のパスの数の積になる。辺が1本のブロック（橋）は必ず通るので核にしない。
+// 核の中では，入口，出口以外の次数 2 の頂点を通るパスはその両側の辺を必ず通るので，
+// 2本の辺を1本の辺（元の辺の鎖）に縮約する。
+
+namespace frontier {
+
+// 前処理で得られた核
+struct ReducedCore {
+	Graph graph; // 縮約後のグラフ（頂点番号は 1 から振り直す。多重辺を含みうる）
+	int s;       // 核の入口の頂点（核での番号）
+	int t;       // 核の出口の頂点（核での番号）
+	std::vector<int> original_vertices; // 核の頂点 v の元の頂点番号は original_vertices[v - 1]
+	std::vector<std::vector<int> > original_edges; // 核の辺 e に対応する元の辺の番号（0始まり）の鎖
+};
+
+// 前処理の結果。元のグラフの s-t パスは，各核の s-t パスを1本ずつ選び，その辺を
+// original_edges で置き換えて forced_edges と合わせたものと1対1に対応する。
+struct ReducedGraph {
+	bool connected; // s と t が連結か（連結でなければ s-t パスはない）
+	std::vector<int> forced_edges; // すべての s-t パスが通る元の辺（橋）の番号
+	std::vector<ReducedCore> cores;
+	int number_of_removed_edges;       // s-t パスが通りえないので除いた辺の数
+	int number_of_contracted_vertices; // 縮約した次数 2 の頂点の数
+};
+
+// graph の s-t パスを数えるための前処理をして，結果を result に格納する。
+// s, t が頂点でないとき（空のグラフなど）と s = t のときは，解のない（連結でない）結果にする
+void ReduceGraph(Graph* graph, int s, int t, ReducedGraph* result);
+
+// 各核の ZDD（core_zdds[k] は cores[k] の graph, s, t で構築したもの）から，元のグラフの
+// s-t パスの族を，元の辺 e（0始まり）を変数 e + 1 とする manager の ZDD にして根を返す。
+// 核の ZDD の1終端を前の核までの族に置き換え，核の辺の1枝は鎖の元の辺をすべて加える
+// （Change）ことにして下から取り込む。各核と forced_edges の辺は互いに素なので，
+// 結果は各核のパスと forced_edges を合わせた集合の族になる。
+// manager の変数の数は元のグラフの辺の数でなければならない
+ZDDManager::NodeId ExpandReducedGraph(const ReducedGraph& reduced,
+	const std::vector<ZDD*>& core_zdds, ZDDManager* manager);
+
+} // namespace frontier
+
+#endif // FRONTIER_REDUCE_H
@@ -0,0 +1,393 @@
+//
+// zddmanager.cpp
+//
+// Copyright (c) 2014 Jun Kawahara
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "zddmanager.h"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+namespace frontier {
+
+// 一意表の大きさの初期値と，演算キャッシュの大きさの初期値・最大値（いずれも2の冪）
+static const size_t kInitialUniqueTableSize = 1 << 12;
+static const size_t kInitialCacheSize = 1 << 12;
+static const size_t kMaxCacheSize = 1 << 24;
+
+static inline uint64_t MixHash(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline uint64_t HashNode(int level, uint32_t lo, uint32_t hi)
+{
+	return MixHash((static_cast<uint64_t>(lo) << 32 | hi) ^ MixHash(level));
+}
+
+ZDDManager::ZDDManager(int number_of_variables)
+	: number_of_variables_(number_of_variables),
+	unique_table_(kInitialUniqueTableSize, 0),
+	cache_(kInitialCacheSize)
+{
+	Node terminal = { number_of_variables + 1, 0, 0 };
+	nodes_.push_back(terminal); // 0終端
+	nodes_.push_back(terminal); // 1終端
+	for (size_t k = 0; k < cache_.size(); ++k) {
+		cache_[k].key = 0;
+	}
+}
+
+ZDDManager::NodeId ZDDManager::MakeNode(int level, NodeId lo, NodeId hi)
+{
+	if (hi == 0) { // 1枝が0終端のノードは除く（ゼロサプレス）
+		return lo;
+	}
+	size_t mask = unique_table_.size() - 1;
+	for (size_t h = HashNode(level, lo, hi) & mask; ; h = (h + 1) & mask) {
+		NodeId id = unique_table_[h];
+		if (id == 0) {
+			break;
+		}
+		const Node& node = nodes_[id];
+		if (node.level == level && node.lo == lo && node.hi == hi) {
+			return id;
+		}
+	}
+
+	NodeId id = static_cast<NodeId>(nodes_.size());
+	Node node = { level, lo, hi };
+	nodes_.push_back(node);
+	if (nodes_.size() * 2 > unique_table_.size()) { // 負荷率が 1/2 を超えたら広げる
+		GrowUniqueTable();
+	} else {
+		size_t h = HashNode(level, lo, hi) & mask;
+		while (unique_table_[h] != 0) {
+			h = (h + 1) & mask;
+		}
+		unique_table_[h] = id;
+	}
+	return id;
+}
+
+// 一意表を2倍にして入れ直す。演算キャッシュもノード数に合わせて広げる
+void ZDDManager::GrowUniqueTable()
+{
+	unique_table_.assign(unique_table_.size() * 2, 0);
+	size_t mask = unique_table_.size() - 1;
+	for (size_t id = 2; id < nodes_.size(); ++id) {
+		const Node& node = nodes_[id];
+		size_t h = HashNode(node.level, node.lo, node.hi) & mask;
+		while (unique_table_[h] != 0) {
+			h = (h + 1) & mask;
+		}
+		unique_table_[h] = static_cast<NodeId>(id);
+	}
+	if (cache_.size() < kMaxCacheSize && cache_.size() < unique_table_.size() / 2) {
+		CacheEntry empty = { 0, 0, 0 };
+		cache_.assign(unique_table_.size() / 2, empty); // 覚えていた結果は捨てる
+	}
+}
+
+bool ZDDManager::Lookup(Operation op, NodeId f, uint64_t arg, NodeId* result)
+{
+	uint64_t key = static_cast<uint64_t>(op) << 32 | f;
+	const CacheEntry& entry = cache_[MixHash(key ^ MixHash(arg)) & (cache_.size() - 1)];
+	if (entry.key == key && entry.arg == arg) {
+		*result = entry.result;
+		return true;
+	}
+	return false;
+}
+
+void ZDDManager::Store(Operation op, NodeId f, uint64_t arg, NodeId result)
+{
+	uint64_t key = static_cast<uint64_t>(op) << 32 | f;
+	CacheEntry& entry = cache_[MixHash(key ^ MixHash(arg)) & (cache_.size() - 1)];
+	entry.key = key;
+	entry.arg = arg;
+	entry.result = result;
+}
+
+ZDDManager::NodeId ZDDManager::Import(ZDD* zdd)
+{
+	// id_map[ZDDNode の ID] は取り込んだノード。子から親へ（レベルの大きい方から）取り込む
+	vector<NodeId> id_map(zdd->GetNumberOfIds(), 0);
+	id_map[1] = 1;
+	for (int i = number_of_variables_; i >= 1; --i) {
+		const vector<ZDDNode*>& N_i = zdd->GetNodeList(i);
+		for (size_t j = 0; j < N_i.size(); ++j) {
+			ZDDNode* node = N_i[j];
+			id_map[node->GetId()] = MakeNode(i, id_map[node->GetChild(0)->GetId()],
+				id_map[node->GetChild(1)->GetId()]);
+		}
+	}
+	const vector<ZDDNode*>& roots = zdd->GetNodeList(1);
+	return (roots.empty() ? 0 : id_map[roots[0]->GetId()]);
+}
+
+ZDDManager::NodeId ZDDManager::Union(NodeId f, NodeId g)
+{
+	if (f == 0 || f == g) {
+		return g;
+	} else if (g == 0) {
+		return f;
+	}
+	if (f > g) { // 可換なので引数の順序をそろえてキャッシュに当たりやすくする
+		std::swap(f, g);
+	}
+	NodeId result;
+	if (Lookup(kOpUnion, f, g, &result)) {
+		return result;
+	}
+	int lf = Level(f), lg = Level(g);
+	if (lf < lg) {
+		result = MakeNode(lf, Union(nodes_[f].lo, g), nodes_[f].hi);
+	} else if (lg < lf) {
+		result = MakeNode(lg, Union(f, nodes_[g].lo), nodes_[g].hi);
+	} else {
+		NodeId lo = Union(nodes_[f].lo, nodes_[g].lo);
+		NodeId hi = Union(nodes_[f].hi, nodes_[g].hi);
+		result = MakeNode(lf, lo, hi);
+	}
+	Store(kOpUnion, f, g, result);
+	return result;
+}
+
+ZDDManager::NodeId ZDDManager::Intersection(NodeId f, NodeId g)
+{
+	if (f == 0 || g == 0) {
+		return 0;
+	} else if (f == g) {
+		return f;
+	}
+	if (f > g) {
+		std::swap(f, g);
+	}
+	NodeId result;
+	if (Lookup(kOpIntersection, f, g, &result)) {
+		return result;
+	}
+	int lf = Level(f), lg = Level(g);
+	if (lf < lg) {
+		result = Intersection(nodes_[f].lo, g);
+	} else if (lg < lf) {
+		result = Intersection(f, nodes_[g].lo);
+	} else {
+		NodeId lo = Intersection(nodes_[f].lo, nodes_[g].lo);
+		NodeId hi = Intersection(nodes_[f].hi, nodes_[g].hi);
+		result = MakeNode(lf, lo, hi);
+	}
+	Store(kOpIntersection, f, g, result);
+	return result;
+}
+
+ZDDManager::NodeId ZDDManager::Difference(NodeId f, NodeId g)
+{
+	if (f == 0 || f == g) {
+		return 0;
+	} else if (g == 0) {
+		return f;
+	}
+	NodeId result;
+	if (Lookup(kOpDifference, f, g, &result)) {
+		return result;
+	}
+	int lf = Level(f), lg = Level(g);
+	if (lf < lg) {
+		result = MakeNode(lf, Difference(nodes_[f].lo, g), nodes_[f].hi);
+	} else if (lg < lf) {
+		result = Difference(f, nodes_[g].lo);
+	} else {
+		NodeId lo = Difference(nodes_[f].lo, nodes_[g].lo);
+		NodeId hi = Difference(nodes_[f].hi, nodes_[g].hi);
+		result = MakeNode(lf, lo, hi);
+	}
+	Store(kOpDifference, f, g, result);
+	return result;
+}
+
+// 辺 e についての OnSet, OffSet, Restrict の共通部分。
+// e より上のレベルのノードは両方の枝に再帰し，レベル e のノードで op に応じて枝を選ぶ
+ZDDManager::NodeId ZDDManager::Cofactor(Operation op, NodeId f, int e)
+{
+	int level = Level(f);
+	if (level > e) { // e を含む集合はない
+		return (op == kOpOnSet || op == kOpRestrict1 ? 0 : f);
+	} else if (level == e) {
+		switch (op) {
+		case kOpOnSet:
+			return MakeNode(e, 0, nodes_[f].hi);
+		case kOpRestrict1:
+			return nodes_[f].hi;
+		default: // kOpOffSet, kOpRestrict0
+			return nodes_[f].lo;
+		}
+	}
+	NodeId result;
+	if (Lookup(op, f, e, &result)) {
+		return result;
+	}
+	NodeId lo = Cofactor(op, nodes_[f].lo, e);
+	NodeId hi = Cofactor(op, nodes_[f].hi, e);
+	result = MakeNode(level, lo, hi);
+	Store(op, f, e, result);
+	return result;
+}
+
+ZDDManager::NodeId ZDDManager::OnSet(NodeId f, int e)
+{
+	return Cofactor(kOpOnSet, f, e);
+}
+
+ZDDManager::NodeId ZDDManager::OffSet(NodeId f, int e)
+{
+	return Cofactor(kOpOffSet, f, e);
+}
+
+ZDDManager::NodeId ZDDManager::Restrict(NodeId f, int e, int x)
+{
+	return Cofactor(x == 1 ? kOpRestrict1 : kOpRestrict0, f, e);
+}
+
+ZDDManager::NodeId ZDDManager::Change(NodeId f, int e)
+{
+	if (f == 0) {
+		return 0;
+	}
+	int level = Level(f);
+	if (level > e) { // e を含む集合はないので，すべての集合に e を加える
+		return MakeNode(e, 0, f);
+	} else if (level == e) {
+		return MakeNode(e, nodes_[f].hi, nodes_[f].lo);
+	}
+	NodeId result;
+	if (Lookup(kOpChange, f, e, &result)) {
+		return result;
+	}
+	NodeId lo = Change(nodes_[f].lo, e);
+	NodeId hi = Change(nodes_[f].hi, e);
+	result = MakeNode(level, lo, hi);
+	Store(kOpChange, f, e, result);
+	return result;
+}
+
+// f から辿れるノード（終端を除く）をレベルごとに levels[レベル] に並べる
+void ZDDManager::CollectNodes(NodeId f, vector<vector<NodeId> >* levels)
+{
+	levels->assign(number_of_variables_ + 2, vector<NodeId>());
+	vector<bool> visited(nodes_.size(), false);
+	vector<NodeId> stack(1, f);
+	while (!stack.empty()) {
+		NodeId id = stack.back();
+		stack.pop_back();
+		if (id < 2 || visited[id]) {
+			continue;
+		}
+		visited[id] = true;
+		(*levels)[nodes_[id].level].push_back(id);
+		stack.push_back(nodes_[id].hi);
+		stack.push_back(nodes_[id].lo);
+	}
+}
+
+int64_t ZDDManager::Count(NodeId f)
+{
+	vector<vector<NodeId> > levels;
+	CollectNodes(f, &levels);
+
+	// 子のレベルは親より大きいので，レベルの大きい方から数える
+	vector<int64_t> count(nodes_.size(), 0);
+	count[1] = 1;
+	for (int i = number_of_variables_; i >= 1; --i) {
+		for (size_t j = 0; j < levels[i].size(); ++j) {
+			const Node& node = nodes_[levels[i][j]];
+			count[levels[i][j]] = count[node.lo] + count[node.hi];
+		}
+	}
+	return count[f];
+}
+
+int64_t ZDDManager::GetNumberOfNodes(NodeId f)
+{
+	vector<vector<NodeId> > levels;
+	CollectNodes(f, &levels);
+	int64_t total = 0;
+	for (size_t i = 0; i < levels.size(); ++i) {
+		total += static_cast<int64_t>(levels[i].size());
+	}
+	return total;
+}
+
+string ZDDManager::ToString(NodeId f)
+{
+	vector<vector<NodeId> > levels;
+	CollectNodes(f, &levels);
+
+	// ノードIDはレベル 1 から順に 2, 3, ... と振り直す
+	vector<int> new_id(nodes_.size(), 0);
+	new_id[1] = 1;
+	int next_id = 2;
+	for (int i = 1; i <= number_of_variables_; ++i) {
+		for (size_t j = 0; j < levels[i].size(); ++j) {
+			new_id[levels[i][j]] = next_id++;
+		}
+	}
+
+	ostringstream oss;
+	for (int i = 1; i <= number_of_variables_; ++i) {
+		oss << "#" << i << "\r\n";
+		for (size_t j = 0; j < levels[i].size(); ++j) {
+			const Node& node = nodes_[levels[i][j]];
+			oss << new_id[levels[i][j]] << ":" << new_id[node.lo] << "," << new_id[node.hi]
+				<< "\r\n";
+		}
+	}
+	return oss.str();
+}
+
+void ZDDManager::Export(NodeId f, ostream* out, ZDDFormat format)
+{
+	vector<vector<NodeId> > levels;
+	CollectNodes(f, &levels);
+	int64_t total = 0;
+	for (size_t i = 0; i < levels.size(); ++i) {
+		total += static_cast<int64_t>(levels[i].size());
+	}
+
+	// 既約なのでそのまま書く。子のレベルは親より大きいので，レベルの大きい方から書く
+	vector<int64_t> new_id(nodes_.size(), 0);
+	new_id[1] = 1;
+	ZDDExporter exporter(out, format, number_of_variables_, total);
+	for (int i = number_of_variables_; i >= 1; --i) {
+		for (size_t j = 0; j < levels[i].size(); ++j) {
+			const Node& node = nodes_[levels[i][j]];
+			new_id[levels[i][j]] = exporter.AddNode(i, new_id[node.lo], new_id[node.hi]);
+		}
+	}
+	exporter.Finish(new_id[f]);
+}
+
+} // namespace frontier
@@ -0,0 +1,137 @@
+//
+// zddmanager.h
+//
+// Copyright (c) 2014 Jun Kawahara
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef FRONTIER_ZDDMANAGER_H
+#define FRONTIER_ZDDMANAGER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "frontier.h"
+
+// 構築した ZDD どうしの集合演算。
+// ノードは ZDDNode ではなく (レベル, 0枝の先, 1枝の先) の組の配列（ノード表）に
+// 持ち，同じ組のノードは一意表で1つにまとめる（既約な ZDD になる）。
+// 演算の結果は演算キャッシュ（直接写像の表）に覚えておき，同じ部分問題を二度解かない。
+// 変数（レベル）i は辺 i（GetEdgeList() の添字 + 1）で，同じグラフ・同じ辺の順序で
+// 構築した ZDD どうしでなければ演算できない。
+// ノードは ZDDManager を破棄するまで解放しない。
+
+namespace frontier {
+
+class ZDDManager {
+public:
+	typedef uint32_t NodeId; // ノード表の添字。0 は0終端（空の族），1 は1終端（{空集合}）
+
+private:
+	struct Node {
+		int level;  // 変数（1 から number_of_variables_）。終端は number_of_variables_ + 1
+		NodeId lo;  // 0枝の先
+		NodeId hi;  // 1枝の先
+	};
+
+	struct CacheEntry {
+		uint64_t key; // 演算と第1引数（0 なら空き）
+		uint64_t arg; // 第2引数
+		NodeId result;
+	};
+
+	int number_of_variables_;
+	std::vector<Node> nodes_;
+	std::vector<NodeId> unique_table_; // ノードの添字の開番地法のハッシュ表（0 なら空き）
+	std::vector<CacheEntry> cache_;
+
+public:
+	// 変数の数（辺の数）を指定して作成する
+	explicit ZDDManager(int number_of_variables);
+
+	// frontier::ZDD を取り込み，根を返す（同じ部分はまとめる）。
+	// zdd は変数の数が number_of_variables でなければならない
+	NodeId Import(ZDD* zdd);
+
+	NodeId Union(NodeId f, NodeId g);        // f と g の和集合
+	NodeId Intersection(NodeId f, NodeId g); // f と g の共通部分
+	NodeId Difference(NodeId f, NodeId g);   // f から g の要素を除いたもの
+
+	// 辺 e（変数。1始まり）を含む集合だけを残す（e は含めたまま）
+	NodeId OnSet(NodeId f, int e);
+	// 辺 e を含まない集合だけを残す
+	NodeId OffSet(NodeId f, int e);
+	// 辺 e を x（0 または 1）に固定したもの。x = 1 なら e を含む集合から e を除いたもの
+	NodeId Restrict(NodeId f, int e, int x);
+	// 各集合の辺 e を反転したもの（e を含まない集合には加え，含む集合からは除く）
+	NodeId Change(NodeId f, int e);
+
+	// f が表す集合族の大きさ（解の個数）を返す
+	int64_t Count(NodeId f);
+
+	// f のノード数（終端を除く）を返す
+	int64_t GetNumberOfNodes(NodeId f);
+
+	// ノード表の大きさ（終端を含む）を返す
+	int64_t GetTableSize()
+	{
+		return static_cast<int64_t>(nodes_.size());
+	}
+
+	// f を ZDD::GetZDDString と同じ形式の文字列にして返す（ノードIDはレベル順に振り直す）
+	std::string ToString(NodeId f);
+
+	// f を ZDDExporter で format の形式にして out に書き出す
+	void Export(NodeId f, std::ostream* out, ZDDFormat format);
+
+private:
+	enum Operation {
+		kOpUnion = 1,
+		kOpIntersection,
+		kOpDifference,
+		kOpOnSet,
+		kOpOffSet,
+		kOpRestrict0,
+		kOpRestrict1,
+		kOpChange
+	};
+
+	int Level(NodeId f)
+	{
+		return nodes_[f].level;
+	}
+
+	// (level, lo, hi) のノードを返す（hi が0終端なら lo を返す。なければ作る）
+	NodeId MakeNode(int level, NodeId lo, NodeId hi);
+
+	// 演算キャッシュを引く。見つかれば result に格納して true を返す
+	bool Lookup(Operation op, NodeId f, uint64_t arg, NodeId* result);
+	void Store(Operation op, NodeId f, uint64_t arg, NodeId result);
+
+	NodeId Cofactor(Operation op, NodeId f, int e);
+
+	void CollectNodes(NodeId f, std::vector<std::vector<NodeId> >* levels);
+
+	void GrowUniqueTable();
+
+	ZDDManager(const ZDDManager&);            // コピー禁止
+	ZDDManager& operator=(const ZDDManager&);
+};
+
+} // namespace frontier
+
+#endif // FRONTIER_ZDDMANAGER_H